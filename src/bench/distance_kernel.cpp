@@ -0,0 +1,234 @@
+/*
+ * Microbenchmark for the max distance search of the Douglas-Peucker
+ * compression.
+ *
+ * The benchmark compares the per-vertex perpendicular_distance() search
+ * that the compression used before with the AVX2, SSE2 and scalar kernels
+ * of functions::max_perpendicular_distance() on a set of border-like
+ * polylines. It measures a single search over each complete polyline,
+ * which isolates the kernel, and the iterative Douglas-Peucker algorithm,
+ * which also searches the short spans near the leaves. It prints the best
+ * time of several runs for each search and its speedup over the per-vertex
+ * search.
+ *
+ * Usage: distance_kernel_bench [points per polyline] [polylines] [runs]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stack>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "functions/distance.hpp"
+#include "model/geometry/point.hpp"
+
+#include "kernels.hpp"
+
+using namespace model::geometry;
+
+/* Types */
+
+/**
+ * A polyline with its points and its coordinate arrays.
+ */
+struct Polyline
+{
+    std::vector<Point<double>> points;
+    std::vector<double> x;
+    std::vector<double> y;
+};
+
+/* Constants */
+
+/**
+ * The distance tolerance in degrees, which keeps about one in seven points
+ * of the generated polylines.
+ */
+const double TOLERANCE = 1e-4;
+
+/* Functions */
+
+/**
+ * Generate a polyline that resembles an administrative border in degrees,
+ * i.e. a random walk with steps of about 10 meters and a slowly changing
+ * direction.
+ */
+Polyline generate(std::size_t size, std::mt19937& random)
+{
+    std::normal_distribution<double> turn{ 0.0, 0.3 };
+    std::uniform_real_distribution<double> step{ 5e-5, 2e-4 };
+    Polyline polyline;
+    double x = 10.0;
+    double y = 50.0;
+    double direction = 0.0;
+    for (std::size_t i = 0; i < size; i++)
+    {
+        polyline.points.push_back(Point<double>{ x, y });
+        polyline.x.push_back(x);
+        polyline.y.push_back(y);
+        direction += turn(random);
+        double length = step(random);
+        x += length * std::cos(direction);
+        y += length * std::sin(direction);
+    }
+    return polyline;
+}
+
+/**
+ * The per-vertex search of the compression before the vectorization, which
+ * calculates the perpendicular distance of each point separately.
+ */
+std::pair<std::size_t, double> per_vertex(const Polyline& polyline, std::size_t start, std::size_t end)
+{
+    std::size_t index = start;
+    double d_max = -1.0;
+    for (std::size_t i = start + 1; i < end; i++)
+    {
+        double d = functions::perpendicular_distance(polyline.points[i], polyline.points[start], polyline.points[end]);
+        if (d > d_max)
+        {
+            index = i;
+            d_max = d;
+        }
+    }
+    return std::make_pair(index, d_max);
+}
+
+/**
+ * Run the iterative Douglas-Peucker algorithm on a polyline with the
+ * specified search and return the number of kept points.
+ */
+template <typename TSearch>
+std::size_t douglas_peucker(const Polyline& polyline, TSearch&& search)
+{
+    std::size_t kept = 2;
+    std::stack<std::pair<std::size_t, std::size_t>> stack;
+    stack.push(std::make_pair(0, polyline.points.size() - 1));
+    while (!stack.empty())
+    {
+        auto [start, end] = stack.top();
+        stack.pop();
+        if (end <= start + 1)
+        {
+            continue;
+        }
+        auto [index, d_max] = search(polyline, start, end);
+        if (d_max > TOLERANCE)
+        {
+            ++kept;
+            stack.push(std::make_pair(start, index));
+            stack.push(std::make_pair(index, end));
+        }
+    }
+    return kept;
+}
+
+/**
+ * Run the function on all polylines several times and return the best
+ * time in milliseconds and the sum of the function results of a run.
+ */
+template <typename TFunction>
+std::pair<double, std::size_t> measure(const std::vector<Polyline>& polylines, std::size_t runs, TFunction&& function)
+{
+    double best = std::numeric_limits<double>::infinity();
+    std::size_t result = 0;
+    for (std::size_t run = 0; run < runs; run++)
+    {
+        result = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const Polyline& polyline : polylines)
+        {
+            result += function(polyline);
+        }
+        std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+        best = std::min(best, duration.count());
+    }
+    return std::make_pair(best, result);
+}
+
+/**
+ * Measure a search with a single search over each complete polyline and
+ * with the Douglas-Peucker algorithm, and print the results relative to
+ * the baseline times.
+ */
+template <typename TSearch>
+std::pair<double, double> report(
+    const std::string& name,
+    const std::string& kernel,
+    const std::vector<Polyline>& polylines,
+    std::size_t runs,
+    TSearch&& search,
+    std::pair<double, double> baseline
+) {
+    auto [span_time, index] = measure(polylines, runs, [&](const Polyline& polyline) {
+        return search(polyline, 0, polyline.points.size() - 1).first;
+    });
+    auto [dp_time, kept] = measure(polylines, runs, [&](const Polyline& polyline) {
+        return douglas_peucker(polyline, search);
+    });
+    if (baseline.first == 0.0)
+    {
+        baseline = std::make_pair(span_time, dp_time);
+    }
+    std::cout << std::left << std::setw(12) << name << std::setw(8) << kernel
+        << std::right << std::fixed << std::setprecision(2)
+        << std::setw(11) << span_time << std::setw(9) << baseline.first / span_time << 'x'
+        << std::setw(11) << dp_time << std::setw(9) << baseline.second / dp_time << 'x'
+        << std::setw(10) << index << std::setw(10) << kept << '\n';
+    return baseline;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t size = argc > 1 ? std::stoul(argv[1]) : 20000;
+    std::size_t count = argc > 2 ? std::stoul(argv[2]) : 50;
+    std::size_t runs = argc > 3 ? std::stoul(argv[3]) : 5;
+    if (size < 2 || count == 0 || runs == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [points per polyline >= 2] [polylines > 0] [runs > 0]\n";
+        return 1;
+    }
+
+    std::mt19937 random{ 42 };
+    std::vector<Polyline> polylines;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        polylines.push_back(generate(size, random));
+    }
+    std::cout << "Douglas-Peucker on " << count << " polylines with " << size
+        << " points, tolerance " << TOLERANCE << ", best of " << runs << " runs\n\n";
+
+    struct Variant
+    {
+        std::string name;
+        const char* kernel;
+        bench::search_type search;
+    };
+    std::vector<Variant> variants{
+        { "avx2", bench::kernel_avx2(), bench::max_distance_avx2 },
+        { "sse2", bench::kernel_sse2(), bench::max_distance_sse2 },
+        { "scalar", bench::kernel_scalar(), bench::max_distance_scalar }
+    };
+
+    // The index and kept columns are checksums, which have to match for all
+    // searches.
+    std::cout << std::left << std::setw(12) << "search" << std::setw(8) << "kernel"
+        << std::right << std::setw(11) << "span [ms]" << std::setw(10) << "speedup"
+        << std::setw(11) << "dp [ms]" << std::setw(10) << "speedup"
+        << std::setw(10) << "index" << std::setw(10) << "kept" << '\n';
+    std::pair<double, double> baseline = report("per-vertex", "-", polylines, runs, per_vertex, { 0.0, 0.0 });
+    for (const Variant& variant : variants)
+    {
+        report(variant.name, variant.kernel, polylines, runs, [&](const Polyline& polyline, std::size_t start, std::size_t end) {
+            return variant.search(polyline.x.data(), polyline.y.data(), start, end);
+        }, baseline);
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+#include "kernels.hpp"
+
+namespace bench
+{
+
+    std::pair<std::size_t, double> max_distance_sse2(const double* x, const double* y, std::size_t start, std::size_t end)
+    {
+        return detail::search(x, y, start, end);
+    }
+
+    const char* kernel_sse2()
+    {
+        return detail::kernel();
+    }
+
+}
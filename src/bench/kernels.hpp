@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+#include "functions/detail/distance_kernel.hpp"
+
+namespace bench
+{
+
+    /* Types */
+
+    /**
+     * The signature of a max distance search, see
+     * functions::max_perpendicular_distance().
+     */
+    using search_type = std::pair<std::size_t, double> (*)(const double*, const double*, std::size_t, std::size_t);
+
+    /* Functions */
+
+    /**
+     * The max distance searches with the AVX2, SSE2 and scalar kernel. Each
+     * search is defined in its own translation unit, which is compiled for
+     * the respective instruction set.
+     */
+    std::pair<std::size_t, double> max_distance_avx2(const double* x, const double* y, std::size_t start, std::size_t end);
+    std::pair<std::size_t, double> max_distance_sse2(const double* x, const double* y, std::size_t start, std::size_t end);
+    std::pair<std::size_t, double> max_distance_scalar(const double* x, const double* y, std::size_t start, std::size_t end);
+
+    /**
+     * The instruction set that the kernel of a search was compiled for,
+     * which differs from its name if the compiler does not support it.
+     */
+    const char* kernel_avx2();
+    const char* kernel_sse2();
+    const char* kernel_scalar();
+
+    namespace detail
+    {
+
+        /**
+         * The search of functions::max_perpendicular_distance() with the
+         * kernel of the including translation unit. It has internal linkage,
+         * so that each translation unit uses its own kernel.
+         */
+        static inline std::pair<std::size_t, double> search(const double* x, const double* y, std::size_t start, std::size_t end)
+        {
+            double dx = x[start] - x[end];
+            double dy = y[start] - y[end];
+            double length = std::hypot(dx, dy);
+            bool line = length > 0.0;
+            auto [index, key] = functions::detail::max_distance_key(x, y, start + 1, end, x[start], y[start], dx, dy, line);
+            return std::make_pair(index, line ? key / length : std::sqrt(key));
+        }
+
+        /**
+         * The name of the kernel of the including translation unit.
+         */
+        static inline const char* kernel()
+        {
+#if defined(MAPMAKER_KERNEL_AVX2)
+            return "avx2";
+#elif defined(MAPMAKER_KERNEL_SSE2)
+            return "sse2";
+#else
+            return "scalar";
+#endif
+        }
+
+    }
+
+}
@@ -22,6 +22,12 @@ class Checkout : public Routine
      */
     fs::path m_input;
 
+    /**
+     * The no-cache flag. If set to true, the header cache file of the input
+     * file is ignored and the input file is scanned again.
+     */
+    bool m_no_cache;
+
     /**
     * The logger.
     */
@@ -35,6 +41,7 @@ public:
     {
         m_options.add_options()
             ("input", po::value<fs::path>()->required(), "Sets the input file path.\nAllowed file formats: .osm, .pbf")
+            ("no-cache", po::bool_switch()->default_value(false), "Forces a scan of the input file instead of loading the headers from the cache file next to it.")
             ("help,h", "Shows this help message");
         m_positional.add("input", 1);
     }
@@ -50,6 +57,7 @@ public:
     {
         Routine::setup();
         this->set<fs::path>(&m_input, "input", util::validate_file);
+        this->set<bool>(&m_no_cache, "no-cache");
         m_log.set_steps(1);
     }
 
@@ -57,9 +65,17 @@ public:
     {       
         // Read the file info of the specified input file
         m_log.start() << "Reading headers from file " << m_input << ".\n";
-        io::HeaderReader reader{ m_input.string() };
+        io::HeaderReader reader{ m_input.string(), !m_no_cache };
         model::Header header = reader.read();
-        m_log.finish();
+        if (reader.cached())
+        {
+            m_log.step() << "Loaded headers from the cache file.\n";
+            m_log.finish();
+        }
+        else
+        {
+            m_log.finish(header.size);
+        }
 
         util::print(std::cout, header);
 
@@ -1,13 +1,19 @@
 #pragma once
 
+#include <iomanip>
+
 #include "routine.hpp"
 
 #include "model/graph/undirected_graph.hpp"
 #include "model/boundary.hpp"
+#include "model/boundary_store.hpp"
 #include "model/types.hpp"
 
-#include "io/reader/header_reader.hpp"
+#include "handler/tag_value_count_handler.hpp"
+
+#include "io/reader/header_cache_reader.hpp"
 #include "io/reader/osm_reader.hpp"
+#include "io/reader/snapshot_reader.hpp"
 #include "io/writer/map_writer.hpp"
 #include "io/writer/mapdata_writer.hpp"
 
@@ -16,9 +22,11 @@
 #include "mapmaker/calculator.hpp"
 #include "mapmaker/compressor.hpp"
 #include "mapmaker/converter.hpp"
-#include "mapmaker/counter.hpp"
 #include "mapmaker/filter.hpp"
 #include "mapmaker/inspector.hpp"
+#include "mapmaker/locator.hpp"
+#include "mapmaker/renumberer.hpp"
+#include "mapmaker/simplifier.hpp"
 
 #include "functions/transform.hpp"
 
@@ -92,16 +100,66 @@ class Create : public Routine
      */
     double m_compression_tolerance;
 
+    /**
+     * The compression algorithm, either "dp" for Douglas-Peucker or "vw" for
+     * Visvalingam-Whyatt.
+     */
+    std::string m_compression_algorithm;
+
+    /**
+     * The distance tolerance in pixels for the simplification of the
+     * projected boundaries. Since the boundaries are projected to the
+     * output pixels, the same tolerance removes the same amount of detail
+     * at every map size.
+     */
+    double m_pixel_tolerance;
+
     /**
      * The surface area tolerance for the filter algorithm.
      */
     double m_filter_tolerance;
 
+    /**
+     * The no-cache flag. If set to true, the header cache file of the input
+     * file is not used for the territory level detection.
+     */
+    bool m_no_cache;
+
+    /**
+     * The type of the node location index, e.g. "flex_mem" or
+     * "sparse_mem_array".
+     */
+    std::string m_location_index;
+
+    /**
+     * The low memory flag. If set to true, the boundaries are read with a
+     * strategy that only stores ids instead of whole ways.
+     */
+    bool m_low_memory;
+
+    /**
+     * The number of threads for the parallel processing steps.
+     */
+    std::size_t m_threads;
+
    /**
     * The verbose logging flag.
     */
     bool m_verbose;
 
+    /**
+     * The node significance ranking of the input snapshot in the order of the
+     * nodes in the buffer, or an empty vector if the input contains no
+     * ranking.
+     */
+    std::vector<double> m_significance;
+
+    /**
+     * The renumberer, which keeps the original ids of the renumbered
+     * objects.
+     */
+    mapmaker::Renumberer m_renumberer;
+
     /**
      * The logger.
      */
@@ -114,14 +172,20 @@ public:
     Create() : Routine()
     {
         m_options.add_options()
-            ("input", po::value<fs::path>()->required(), "Sets the input file path.\nAllowed file formats: .osm, .pbf")
+            ("input", po::value<fs::path>()->required(), "Sets the input file path.\nAllowed file formats: .osm, .pbf, .wzbuf")
             ("outdir,o", po::value<fs::path>()->default_value(""), "Sets the output folder for the generated map files.")
             ("territory-level,t", po::value<level_type>()->default_value(0), "Sets the admin_level of boundaries that will be be used as territories.\nInteger between 1 and 12.")
             ("bonus-levels,b", po::value<std::vector<level_type>>()->multitoken(), "Sets the admin_level of boundaries that will be be used as bonus links.\nInteger between 1 and 12. If none are specified, no bonus links will be generated.")
             ("width", po::value<int>()->default_value(1000), "Sets the generated map width in pixels.\nIf set to 0, the width will be determined automatically with the height.")
             ("height", po::value<int>()->default_value(0), "Sets the generated map height in pixels.\nIf set to 0, the height will be determined automatically with the width.")
             ("compression-tolerance,c", po::value<double>()->default_value(0.0), "Sets the minimum distance tolerance for the compression algorithm.\nIf set to 0, no compression will be applied.")
+            ("compression-algorithm", po::value<std::string>()->default_value("dp"), "Sets the line simplification algorithm of the compression.\nAllowed algorithms: dp (Douglas-Peucker), vw (Visvalingam-Whyatt)")
+            ("pixel-tolerance", po::value<double>()->default_value(0.5), "Sets the distance tolerance in pixels for the simplification of the projected boundaries.\nIf set to 0, no pixel simplification will be applied.")
             ("filter-tolerance,f", po::value<double>()->default_value(0.0), "Sets the surface area ratio tolerance for filtering boundaries.\nIf set to 0, no filter will be applied.")
+            ("no-cache", po::bool_switch()->default_value(false), "Ignores the header cache file of the input file when the territory level is determined automatically.")
+            ("location-index", po::value<std::string>()->default_value("flex_mem"), "Sets the type of the node location index. File-backed indexes are stored in the output directory.\nAllowed types: flex_mem, dense_mem_array, sparse_mem_array, dense_mmap_array, sparse_mmap_array, dense_file_array, sparse_file_array")
+            ("low-memory", po::bool_switch()->default_value(false), "Reduces the memory usage when reading large input files by only storing ids instead of whole ways. The ways of incomplete boundaries will be kept in the result.")
+            ("threads,j", po::value<std::size_t>()->default_value(1), "Sets the number of threads for the boundary assembly, the compression and the neighbor detection.\nIf set to 0, all available hardware threads will be used.")
             ("verbose", po::bool_switch()->default_value(false), "Enables verbose logging.")
             ("help,h", "Shows this help message.");
         m_positional.add("input", 1);
@@ -147,12 +211,19 @@ public:
         this->set<int>(&m_height, "height");
         util::validate_dimensions(m_width, m_height);
         this->set<double>(&m_compression_tolerance, "compression-tolerance", util::validate_epsilon);
+        this->set<std::string>(&m_compression_algorithm, "compression-algorithm", util::validate_compression_algorithm);
+        this->set<double>(&m_pixel_tolerance, "pixel-tolerance", util::validate_epsilon);
         this->set<double>(&m_filter_tolerance, "filter-tolerance", util::validate_epsilon);
+        this->set<bool>(&m_no_cache, "no-cache");
+        this->set<std::string>(&m_location_index, "location-index", util::validate_location_index);
+        this->set<bool>(&m_low_memory, "low-memory");
+        this->set<std::size_t>(&m_threads, "threads");
         this->set<bool>(&m_verbose, "verbose");
         // fs::create_directory(m_dir / "out");#
         // Calculate the total number of steps for the routine
         std::size_t steps = 10 + (m_compression_tolerance > 0.0)
                     + (m_filter_tolerance > 0.0)
+                    + (m_pixel_tolerance > 0.0)
                     + (!m_bonus_levels.empty());
         m_log.set_steps(steps);
     }
@@ -161,49 +232,176 @@ private:
 
     /* Helper methods */
 
-    Header read_header(const fs::path& file_path)
+    level_type detect_level(const buffer_t& buffer)
     {
-        // Prepare the header reader for the input file and retrieve the header
-        io::HeaderReader reader{ file_path.string() };
-        return reader.read();
+        // Count the admin_level values of the relations in the buffer and
+        // select the most common one.
+        handler::TagValueCountHandler<level_type> level_count_handler{ "admin_level", osmium::item_type::relation };
+        osmium::apply(buffer, level_count_handler);
+        const auto& counts = level_count_handler.counts();
+        if (counts.empty())
+        {
+            throw std::runtime_error(
+                "Unable to detect the territory level, as the input file "
+                "contains no relations with an admin_level"
+            );
+        }
+        auto it = std::max_element(counts.cbegin(), counts.cend(),
+            [](const auto& e1, const auto& e2)
+            {
+                return e1.second < e2.second;
+            }
+        );
+        return it->first;
     }
 
-    osmium::memory::Buffer read_data(const fs::path& file_path, std::set<level_type> levels)
+    buffer_t read_data(const fs::path& file_path)
     {
+        // Snapshot files written by the prepare routine are loaded directly
+        // into the buffer. They contain the boundaries of all levels, so the
+        // territory level can be detected from the buffer itself.
+        if (file_path.extension() == io::SNAPSHOT_EXTENSION)
+        {
+            io::SnapshotReader reader{ file_path };
+            buffer_t buffer = reader.read();
+            m_significance = reader.significance();
+            if (m_territory_level == 0)
+            {
+                m_territory_level = detect_level(buffer);
+                m_log.step() << "Detected territory level " << m_territory_level << ".\n";
+            }
+            return buffer;
+        }
+
+        // If the territory level was set to auto and a valid header cache
+        // exists for the input file, select the most common level from the
+        // cached level distribution.
+        if (m_territory_level == 0 && !m_no_cache)
+        {
+            io::HeaderCacheReader cache_reader{ file_path };
+            if (cache_reader.valid())
+            {
+                Header header = cache_reader.read();
+                if (!header.levels.empty())
+                {
+                    auto [l, c] = *std::max_element(header.levels.cbegin(), header.levels.cend(),
+                        [](const std::pair<level_type, std::size_t>& e1, const std::pair<level_type, std::size_t>& e2)
+                        {
+                            return e1.second < e2.second;
+                        }
+                    );
+                    m_territory_level = l;
+                    m_log.step() << "Detected territory level " << m_territory_level << " from the header cache.\n";
+                }
+            }
+        }
+
+        // If the territory level is still set to auto, the boundary reader
+        // determines the most common admin_level during its relation pass and
+        // only extracts the boundaries with this level.
+        if (m_territory_level == 0)
+        {
+            io::BoundaryReader reader{ file_path, true };
+            reader.low_memory(m_low_memory);
+            buffer_t buffer = reader.read();
+            m_territory_level = *reader.levels().begin();
+            m_log.step() << "Detected territory level " << m_territory_level << ".\n";
+            return buffer;
+        }
+
         // Retrieve the administrative boundaries with and admin_level that
-        // matches the prepared level filter from the input file
-        io::BoundaryReader reader{ m_input, levels };
+        // matches the specified territory and bonus levels from the input file
+        std::set<level_type> levels{ m_bonus_levels.begin(), m_bonus_levels.end() };
+        levels.insert(m_territory_level);
+        io::BoundaryReader reader{ file_path, levels };
+        reader.low_memory(m_low_memory);
         return reader.read();
     }
 
-    void compress(buffer_t& buffer)
+    void renumber(buffer_t& buffer)
     {
-        // Count the nodes before the compression
-        mapmaker::NodeCounter counter;
-        std::size_t before = counter.run(buffer);
+        // Replace the original ids with dense ids, which are assigned in the
+        // order of the original ids. The renumberer keeps the original ids,
+        // so that they can be restored for the output.
+        m_renumberer.run(buffer);
+
+        m_log.step() << "Renumbered " << m_renumberer.nodes() << " nodes, "
+            << m_renumberer.ways() << " ways and "
+            << m_renumberer.relations() << " relations.\n";
+    }
 
-        // Compress the extracted ways using the specified compression
-        // tolerance
-        mapmaker::Compressor compressor{ m_compression_tolerance };
-        compressor.run(buffer);
+    void locate(buffer_t& buffer)
+    {
+        // Build the node location index once and store the node locations
+        // in the way node references, so that the following stages do not
+        // have to build their own index. File-backed indexes are stored in
+        // the output directory.
+        mapmaker::Locator locator{ m_location_index, m_outdir };
+        locator.run(buffer);
+    }
 
-        // Count the nodes after the compression
-        std::size_t after = counter.run(buffer);
+    void compress(buffer_t& buffer)
+    {
+        // Compress the extracted ways using the specified compression
+        // tolerance and algorithm. The compressor counts the nodes and arcs
+        // while it rebuilds the buffer.
+        handler::CompressionAlgorithm algorithm = m_compression_algorithm == "vw"
+            ? handler::CompressionAlgorithm::vw
+            : handler::CompressionAlgorithm::dp;
+        mapmaker::Compressor compressor{ m_compression_tolerance, m_threads, algorithm };
+        if (m_significance.empty() || algorithm != handler::CompressionAlgorithm::dp)
+        {
+            compressor.run(buffer);
+        }
+        else
+        {
+            // The snapshot contains a node significance ranking, so the
+            // compression is a threshold filter. The ranking is stored in the
+            // order of the nodes, which is kept by the renumbering.
+            std::vector<double> significance;
+            std::size_t i = 0;
+            for (const osmium::Node& node : buffer.select<osmium::Node>())
+            {
+                if (node.positive_id() >= significance.size())
+                {
+                    significance.resize(node.positive_id() + 1, std::numeric_limits<double>::infinity());
+                }
+                significance[node.positive_id()] = m_significance.at(i++);
+            }
+            m_significance = {};
+            m_log.step() << "Using the node significance ranking stored in the input file.\n";
+            compressor.run(buffer, significance);
+        }
 
-        m_log.step() << "Compressed " << before << " nodes to " << after << " nodes.\n";
+        // Report the vertex reduction and the runtime of the algorithm
+        double reduction = compressor.nodes_before() > 0
+            ? 100.0 * (compressor.nodes_before() - compressor.nodes_after()) / compressor.nodes_before()
+            : 0.0;
+        m_log.step() << "Compressed " << compressor.nodes_before() << " nodes to " << compressor.nodes_after()
+            << " nodes (-" << std::fixed << std::setprecision(1) << reduction << std::defaultfloat << "%) in "
+            << compressor.arcs() << " arcs with " << m_compression_algorithm << " in " << compressor.duration() << " ms.\n";
     }
 
-    void assemble(buffer_t& buffer, std::set<level_type> levels, bool split)
+    buffer_t assemble(const buffer_t& buffer)
     {
-        // Create the assembler depending on the split strategy.
-        mapmaker::Assembler assembler{ levels, split };
-        assembler.run(buffer);
+        // Assemble the territories and bonuses in a single run. Territories
+        // are split into polygons, while bonuses are kept as multipolygons.
+        std::map<level_type, bool> levels{ { m_territory_level, true } };
+        for (const level_type& level : m_bonus_levels)
+        {
+            levels.emplace(level, false);
+        }
+        mapmaker::Assembler assembler{ levels, m_threads };
+        assembler.original_ids([this](osmium::object_id_type id) {
+            return m_renumberer.original_area_id(id);
+        });
+        return assembler.run(buffer);
     }
 
-    graph_t get_neighbors(const buffer_t& buffer, level_type level)
+    graph_t get_neighbors(const BoundaryStore& store, level_type level)
     {
-        mapmaker::NeighborInspector inspector{ level };
-        return inspector.run(buffer);
+        mapmaker::NeighborInspector inspector{ level, m_threads };
+        return inspector.run(store);
     }
 
     component_t get_components(const graph_t& neighbors)
@@ -212,19 +410,18 @@ private:
         return inspector.run(neighbors);
     }
     
-    void filter(buffer_t& buffer, graph_t& neighbors, component_t& components){
+    void filter(BoundaryStore& store, graph_t& neighbors, component_t& components){
         // Count the areas before the filter process
-        mapmaker::AreaCounter counter;
-        std::size_t before = counter.run(buffer);
+        std::size_t before = store.size();
 
-        // Apply the area filter on the area buffer using the specified tolerance
+        // Apply the area filter on the boundary store using the specified tolerance
         mapmaker::AreaFilter filter{ m_filter_tolerance };
-        filter.run(buffer, neighbors, components);
+        filter.run(store, neighbors, components);
 
-        // Count the nodes after the filter process
-        std::size_t after = counter.run(buffer);
+        // Count the areas after the filter process
+        std::size_t after = store.size();
 
-        m_log.step() << "Compressed " << before << " nodes to " << after << " nodes.\n";
+        m_log.step() << "Filtered " << before << " areas to " << after << " areas.\n";
     }
     
     template <typename T>
@@ -234,13 +431,13 @@ private:
         transformation.transform(bounds.max().x(), bounds.max().y());
     }
 
-    container_t convert(buffer_t& buffer)
+    container_t convert(const BoundaryStore& store)
     {     
-        // Prepare the transformations that will be applied on the buffer before
+        // Prepare the transformations that will be applied on the areas before
         // the geometry conversion. At first, calculate the bounding box of the
-        // nodes in the buffer.
+        // areas in the store.
         mapmaker::BoundsCalculator<T> bounds_calculator{};
-        geometry::Rectangle<T> bounds = bounds_calculator.run(buffer);
+        geometry::Rectangle<T> bounds = bounds_calculator.run(store);
 
         // The radian transformation converts the nodes, for which the locations
         // are specified in degrees, to radians, for futher usage in the Mercator
@@ -290,7 +487,22 @@ private:
             // std::make_shared<functions::MirrorTransformation<T>>(mirror_transformation),
             std::make_shared<functions::ScaleTransformation<T>>(scale_transformation)
         };
-        return converter.run(buffer);
+        return converter.run(store);
+    }
+
+    void simplify(container_t& boundaries)
+    {
+        // Simplify the projected rings, so that vertices that are closer to
+        // their simplified border than the tolerance do not reach the later
+        // stages. Shared borders are simplified identically.
+        mapmaker::RingSimplifier<T> simplifier{ m_pixel_tolerance };
+        simplifier.run(boundaries);
+
+        double reduction = simplifier.points_before() > 0
+            ? 100.0 * (simplifier.points_before() - simplifier.points_after()) / simplifier.points_before()
+            : 0.0;
+        m_log.step() << "Simplified " << simplifier.points_before() << " points to " << simplifier.points_after()
+            << " points (-" << std::fixed << std::setprecision(1) << reduction << std::defaultfloat << "%).\n";
     }
 
     void calculate_centers(container_t& boundaries)
@@ -350,89 +562,103 @@ public:
         // Print the title
         std::cout << util::title() << std::endl;
 
-        // Step 1: Read the file header and determine the territory level
-        // automatically if it was not set.
-        m_log.start() << "Retrieving headers from file " << m_input << ".\n";
-        Header header = read_header(m_input);
-        if (m_territory_level == 0)
-        {
-            auto [l, c] = *std::max_element(header.levels.cbegin(), header.levels.cend(),
-                [](const std::pair<short, std::size_t>& e1, const std::pair<short, std::size_t>& e2)
-                {
-                    return e1.second < e2.second;
-                }
-            );
-            m_territory_level = l;
-        } 
-        // Prepare the level filter with the specified territory and bonus
-        // levels
-        std::set<level_type> levels{ m_bonus_levels.begin(), m_bonus_levels.end() };
-        levels.insert(m_territory_level);
+        // Step 1: Read the boundaries from the specified input file. If the
+        // territory level was not set, it is determined automatically while
+        // reading.
+        m_log.start() << "Reading boundaries from file " << m_input << ".\n";
+        buffer_t buffer = read_data(m_input);
+        m_log.finish(fs::file_size(m_input));
+
+        // Step 2: Renumber the nodes, ways and relations with dense ids, so
+        // that the following steps can index their data by id.
+        m_log.start() << "Renumbering the extracted objects.\n";
+        renumber(buffer);
         m_log.finish();
 
-        // Step 2: Prepare the level filter and read the boundaries from
-        // the specified input file.
-        m_log.start() << "Reading boundaries from file " << m_input << ".\n";
-        buffer_t buffer = read_data(m_input, levels);
+        // Step 3: Resolve the node locations of the extracted ways, unless
+        // the input file already stored them on the ways.
+        if (mapmaker::Locator::located(buffer))
+        {
+            m_log.start() << "Using the node locations stored in the input file.\n";
+        }
+        else
+        {
+            m_log.start() << "Resolving node locations with index type " << m_location_index << ".\n";
+            locate(buffer);
+        }
         m_log.finish();
 
-        // Step 3: Compress the extracted ways using the Douglas-Peucker
-        // algorithm if a compression threshold was specified.
+        // Step 4: Compress the extracted ways using the Douglas-Peucker or
+        // Visvalingam-Whyatt algorithm if a compression threshold was
+        // specified.
         if (m_compression_tolerance > 0)
         {
-            m_log.start() << "Compressing ways with tolerance " << m_compression_tolerance << ".\n";
+            m_log.start() << "Compressing ways with tolerance " << m_compression_tolerance
+                << " using the " << m_compression_algorithm << " algorithm.\n";
             compress(buffer);
             m_log.finish();
         }
 
-        // Step 4: Assemble the territory boundaries using the built-in
-        // multipolygon assembler.
-        m_log.start() << "Assembling territories with level " << m_territory_level << ".\n";
-        assemble(buffer, { m_territory_level }, true);
+        // Step 5: Assemble the territory and bonus boundaries using the
+        // built-in multipolygon assembler.
+        if (m_bonus_levels.empty())
+        {
+            m_log.start() << "Assembling territories with level " << m_territory_level << ".\n";
+        }
+        else
+        {
+            m_log.start() << "Assembling territories with level " << m_territory_level
+                << " and bonuses with the levels " << util::join(m_bonus_levels) << ".\n";
+        }
+        BoundaryStore store{ assemble(buffer) };
         m_log.finish();
+
+        // The raw objects are not needed anymore after the assembly, as all
+        // following steps only work on the assembled areas.
+        buffer = buffer_t{};
         
-        // Step 5: Create the neighbor graph for the assembled territories.
+        // Step 6: Create the neighbor graph for the assembled territories.
         m_log.start() << "Calculating neighborships for territories.\n";
-        graph::UndirectedGraph neighbors = get_neighbors(buffer, m_territory_level);
+        graph::UndirectedGraph neighbors = get_neighbors(store, m_territory_level);
         m_log.finish();
 
-        // Step 6: Calculate the connected components for the neighbor graph.
+        // Step 7: Calculate the connected components for the neighbor graph.
         // This yields the islands of the map.
         m_log.start() << "Finding territory islands.\n";
         component_t components = get_components(neighbors);
         m_log.finish();
 
-        // Step 7: Filter connected components by their surface area if a filter
+        // Step 8: Filter connected components by their surface area if a filter
         // threshold was specified.
         if (m_filter_tolerance > 0)
         {
-            m_log.start() << "Compressing ways with tolerance " << m_filter_tolerance << ".\n";
-            filter(buffer, neighbors, components);
+            m_log.start() << "Filtering areas with surface tolerance " << m_filter_tolerance << ".\n";
+            filter(store, neighbors, components);
             m_log.finish();
         }
 
-        // Step 8: Assemble the bonus boundarties using the built-in multipolygon
-        // assembler if any bonus levels were specified.
-        if (!m_bonus_levels.empty())
-        {
-            m_log.start() << "Assembling bonuses with the levels " << util::join(m_bonus_levels) << ".\n";
-            assemble(buffer, std::set<level_type>(m_bonus_levels.begin(), m_bonus_levels.end()), false);
-            m_log.finish();
-        }
-        
         // Step 9: Create the boundary geometries from the assembled boundaries by
         // applying the map projections and transformations first and converting
         // the osmium objects to geometry objects afterwards.
         m_log.start() << "Building the boundary geometries from the OpenStreetMap objects.\n";
-        std::map<object_id_type, Boundary<T>> boundaries = convert(buffer);
+        std::map<object_id_type, Boundary<T>> boundaries = convert(store);
         m_log.finish();
+
+        // Step 10: Simplify the projected boundary geometries in pixel space
+        // if the pixel tolerance is not disabled.
+        if (m_pixel_tolerance > 0)
+        {
+            m_log.start() << "Simplifying the boundary geometries with pixel tolerance " << m_pixel_tolerance << ".\n";
+            simplify(boundaries);
+            m_log.finish();
+        }
         
-        // Step 10: Calculate the center points for each boundary
+        // Step 11: Calculate the center points for each boundary
         m_log.start() << "Calculating the center points for " << boundaries.size() << " boundaries.\n";
         calculate_centers(boundaries);
         m_log.finish();
 
-        // Step 11: Calculate the hirarchy of territories, bonuses and super bonuses
+        // Step 12: Calculate the hirarchy of territories, bonuses and super bonuses
         // if any bonus levels were specified
         hierarchy_t hierarchy = {};
         if (!m_bonus_levels.empty())
@@ -442,19 +668,19 @@ public:
             m_log.finish();
         }
 
-        // Step 12: Build the map with the generated data
+        // Step 13: Build the map with the generated data
         m_log.start() << "Building the Warzone map.\n";
         // Create the map name from the input file name
         std::string name = std::regex_replace(
             m_input.filename().string(),
-            std::regex("(\\.osm|\\.pbf)"),
+            std::regex("(\\.osm|\\.pbf|\\.wzbuf)"),
             ""
         );
         // Build the map
         warzone::Map map = build_map(name, boundaries, neighbors, hierarchy);
         m_log.finish();
 
-        // Step 13: Export the generated Warzone map and the calculated mapdata
+        // Step 14: Export the generated Warzone map and the calculated mapdata
         // to the specified output directory
         m_log.start() << "Exporting the generated map files.\n";
         export_map(std::move(map));
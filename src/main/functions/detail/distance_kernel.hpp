@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+// The vectorized paths can be disabled with MAPMAKER_NO_SIMD, e.g. to
+// compare them with the scalar path.
+#if !defined(MAPMAKER_NO_SIMD) && defined(__AVX2__)
+#define MAPMAKER_KERNEL_AVX2
+#elif !defined(MAPMAKER_NO_SIMD) && defined(__SSE2__)
+#define MAPMAKER_KERNEL_SSE2
+#endif
+
+#if defined(MAPMAKER_KERNEL_AVX2) || defined(MAPMAKER_KERNEL_SSE2)
+#include <immintrin.h>
+#endif
+
+namespace functions
+{
+
+    namespace detail
+    {
+
+        // The kernel is placed in a namespace for the selected instruction
+        // set, so that translation units that are compiled for different
+        // instruction sets do not share its inline definitions.
+#if defined(MAPMAKER_KERNEL_AVX2)
+        inline namespace avx2
+#elif defined(MAPMAKER_KERNEL_SSE2)
+        inline namespace sse2
+#else
+        inline namespace scalar
+#endif
+        {
+
+            /* Functions */
+
+            /**
+             * Calculates the distance key of a point relative to a line through
+             * the point (sx, sy) with the direction (dx, dy). If the line flag is
+             * set, the key is the absolute cross product of the direction and the
+             * point-to-start vector, which is the perpendicular distance scaled by
+             * the direction length. Otherwise, the key is the squared distance to
+             * the start point.
+             */
+            inline double distance_key(double x, double y, double sx, double sy, double dx, double dy, bool line)
+            {
+                double px = x - sx;
+                double py = y - sy;
+                return line ? std::abs(dx * py - dy * px) : px * px + py * py;
+            }
+
+            /**
+             * Finds the first point with the greatest distance key in the index
+             * range [begin, end) of a polyline, whose coordinates are stored in
+             * two contiguous arrays.
+             *
+             * The search is vectorized with AVX2 or SSE2 if the compiler targets
+             * these instruction sets. Each vector lane keeps the first maximum of
+             * its points, and the lanes are reduced to the maximum with the
+             * lowest index, so the result matches the scalar search.
+             *
+             * @param x     The x coordinates
+             * @param y     The y coordinates
+             * @param begin The first index
+             * @param end   The index after the last index
+             * @param sx    The x coordinate of the line start
+             * @param sy    The y coordinate of the line start
+             * @param dx    The x component of the line direction
+             * @param dy    The y component of the line direction
+             * @param line  The line flag, see distance_key()
+             * @returns     The index and the key of the point
+             *
+             * Time complexity: Linear
+             */
+            inline std::pair<std::size_t, double> max_distance_key(
+                const double* x,
+                const double* y,
+                std::size_t begin,
+                std::size_t end,
+                double sx,
+                double sy,
+                double dx,
+                double dy,
+                bool line
+            ){
+                std::size_t index = begin;
+                double key_max = -1.0;
+                std::size_t i = begin;
+
+#if defined(MAPMAKER_KERNEL_AVX2)
+                if (end - begin >= 4)
+                {
+                    const __m256d vsx = _mm256_set1_pd(sx);
+                    const __m256d vsy = _mm256_set1_pd(sy);
+                    const __m256d vdx = _mm256_set1_pd(dx);
+                    const __m256d vdy = _mm256_set1_pd(dy);
+                    const __m256d sign = _mm256_set1_pd(-0.0);
+                    const __m256d step = _mm256_set1_pd(4.0);
+                    __m256d vmax = _mm256_set1_pd(-1.0);
+                    __m256d vbest = _mm256_setzero_pd();
+                    __m256d vindex = _mm256_setr_pd(
+                        static_cast<double>(i), static_cast<double>(i + 1),
+                        static_cast<double>(i + 2), static_cast<double>(i + 3)
+                    );
+                    for (; i + 4 <= end; i += 4)
+                    {
+                        __m256d px = _mm256_sub_pd(_mm256_loadu_pd(x + i), vsx);
+                        __m256d py = _mm256_sub_pd(_mm256_loadu_pd(y + i), vsy);
+                        __m256d key = line
+                            ? _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_mul_pd(vdx, py), _mm256_mul_pd(vdy, px)))
+                            : _mm256_add_pd(_mm256_mul_pd(px, px), _mm256_mul_pd(py, py));
+                        __m256d greater = _mm256_cmp_pd(key, vmax, _CMP_GT_OQ);
+                        vmax = _mm256_blendv_pd(vmax, key, greater);
+                        vbest = _mm256_blendv_pd(vbest, vindex, greater);
+                        vindex = _mm256_add_pd(vindex, step);
+                    }
+                    double maxs[4];
+                    double bests[4];
+                    _mm256_storeu_pd(maxs, vmax);
+                    _mm256_storeu_pd(bests, vbest);
+                    for (std::size_t lane = 0; lane < 4; lane++)
+                    {
+                        std::size_t best = static_cast<std::size_t>(bests[lane]);
+                        if (maxs[lane] > key_max || (maxs[lane] == key_max && best < index))
+                        {
+                            key_max = maxs[lane];
+                            index = best;
+                        }
+                    }
+                }
+#elif defined(MAPMAKER_KERNEL_SSE2)
+                if (end - begin >= 2)
+                {
+                    const __m128d vsx = _mm_set1_pd(sx);
+                    const __m128d vsy = _mm_set1_pd(sy);
+                    const __m128d vdx = _mm_set1_pd(dx);
+                    const __m128d vdy = _mm_set1_pd(dy);
+                    const __m128d sign = _mm_set1_pd(-0.0);
+                    const __m128d step = _mm_set1_pd(2.0);
+                    __m128d vmax = _mm_set1_pd(-1.0);
+                    __m128d vbest = _mm_setzero_pd();
+                    __m128d vindex = _mm_setr_pd(static_cast<double>(i), static_cast<double>(i + 1));
+                    for (; i + 2 <= end; i += 2)
+                    {
+                        __m128d px = _mm_sub_pd(_mm_loadu_pd(x + i), vsx);
+                        __m128d py = _mm_sub_pd(_mm_loadu_pd(y + i), vsy);
+                        __m128d key = line
+                            ? _mm_andnot_pd(sign, _mm_sub_pd(_mm_mul_pd(vdx, py), _mm_mul_pd(vdy, px)))
+                            : _mm_add_pd(_mm_mul_pd(px, px), _mm_mul_pd(py, py));
+                        // SSE2 has no blend instruction, so the lanes are
+                        // selected with bit masks
+                        __m128d greater = _mm_cmpgt_pd(key, vmax);
+                        vmax = _mm_or_pd(_mm_and_pd(greater, key), _mm_andnot_pd(greater, vmax));
+                        vbest = _mm_or_pd(_mm_and_pd(greater, vindex), _mm_andnot_pd(greater, vbest));
+                        vindex = _mm_add_pd(vindex, step);
+                    }
+                    double maxs[2];
+                    double bests[2];
+                    _mm_storeu_pd(maxs, vmax);
+                    _mm_storeu_pd(bests, vbest);
+                    for (std::size_t lane = 0; lane < 2; lane++)
+                    {
+                        std::size_t best = static_cast<std::size_t>(bests[lane]);
+                        if (maxs[lane] > key_max || (maxs[lane] == key_max && best < index))
+                        {
+                            key_max = maxs[lane];
+                            index = best;
+                        }
+                    }
+                }
+#endif
+
+                // Scalar search for the remaining points, or for all points if
+                // no vector instruction set is available
+                for (; i < end; i++)
+                {
+                    double key = distance_key(x[i], y[i], sx, sy, dx, dy, line);
+                    if (key > key_max)
+                    {
+                        key_max = key;
+                        index = i;
+                    }
+                }
+                return std::make_pair(index, key_max);
+            }
+
+        }
+
+    }
+
+}
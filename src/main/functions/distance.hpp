@@ -1,12 +1,15 @@
 #pragma once
 
+#include <cfloat>
 #include <cmath>
+#include <utility>
 
 #include "model/geometry/point.hpp"
 #include "model/geometry/rectangle.hpp"
 #include "model/geometry/ring.hpp"
 
 #include "functions/util.hpp"
+#include "functions/detail/distance_kernel.hpp"
 
 using namespace model::geometry;
 
@@ -68,6 +71,35 @@ namespace functions
         return distance(ps, line_plumb);
     }
 
+    /**
+     * Find the point with the greatest perpendicular distance to the line
+     * between the start and end point of a polyline, whose coordinates are
+     * stored in two contiguous arrays. Only the points between the start
+     * and end point are considered. If the start and end point are equal,
+     * the distance to the start point is used instead.
+     *
+     * The search is vectorized if the compiler targets AVX2 or SSE2.
+     *
+     * @param x     The x coordinates
+     * @param y     The y coordinates
+     * @param start The index of the start point
+     * @param end   The index of the end point, which has to be greater than
+     *              start + 1
+     * @returns     The index of the first point with the greatest distance
+     *              and the distance
+     *
+     * Time complexity: Linear
+     */
+    inline std::pair<std::size_t, double> max_perpendicular_distance(const double* x, const double* y, std::size_t start, std::size_t end)
+    {
+        double dx = x[start] - x[end];
+        double dy = y[start] - y[end];
+        double length = std::hypot(dx, dy);
+        bool line = length > 0.0;
+        auto [index, key] = detail::max_distance_key(x, y, start + 1, end, x[start], y[start], dx, dy, line);
+        return std::make_pair(index, line ? key / length : std::sqrt(key));
+    }
+
     /**
      * Calculate the minimal (signed) distance of to a ring.
      * 
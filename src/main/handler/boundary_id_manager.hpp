@@ -0,0 +1,322 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <vector>
+
+#include <osmium/handler.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include "handler/boundary_manager.hpp"
+#include "model/types.hpp"
+
+namespace handler
+{
+
+    /**
+     * This class collects the same data as the handler::BoundaryManager,
+     * but only stores ids instead of stashing the member ways of the
+     * boundary relations until the relations are complete.
+     *
+     * In the relation pass, the ids of the member ways of every boundary
+     * relation are recorded. In the way pass, the member ways are marked and
+     * copied and their nodes are marked as the ways pass by. Afterwards, the
+     * relations whose member ways were all found are marked as complete.
+     *
+     * The memory usage scales with the number of ids instead of the size of
+     * the ways. In contrast to the handler::BoundaryManager, the ways and
+     * nodes of incomplete relations are marked too, as the completeness of
+     * a relation is only known after the way pass.
+     */
+    class BoundaryIdManager : public osmium::handler::Handler
+    {
+    public:
+
+        /* Types */
+
+        using nwr_array = osmium::nwr_array<osmium::index::IdSetDense<osmium::unsigned_object_id_type>>;
+
+    protected:
+
+        /**
+         * The compact representation of a boundary relation, which refers
+         * to a range of member way ids.
+         */
+        struct RelationEntry
+        {
+            osmium::object_id_type id;
+            model::level_type level;
+            std::size_t begin;
+            std::size_t end;
+        };
+
+        /* Members */
+
+        /**
+         * The admin_level filter. Only boundaries with an administrative
+         * level contained in this set are marked.
+         */
+        std::set<model::level_type> m_levels;
+
+        /**
+         * The boundary relations recorded in the relation pass.
+         */
+        std::vector<RelationEntry> m_relations;
+
+        /**
+         * The member way ids of the recorded relations. Each relation refers
+         * to a contiguous range of this vector.
+         */
+        std::vector<osmium::unsigned_object_id_type> m_members;
+
+        /**
+         * The ids of the member ways of the relations that match the level
+         * filter. This set is built by prepare_for_lookup().
+         */
+        osmium::index::IdSetDense<osmium::unsigned_object_id_type> m_member_ways;
+
+        /**
+         * The ids of the marked nodes, ways and relations.
+         */
+        nwr_array m_matching_ids;
+
+        /**
+         * The copies of the marked ways.
+         */
+        osmium::memory::Buffer m_ways{ 1024, osmium::memory::Buffer::auto_grow::yes };
+
+        /**
+         * The copies of the recorded relations that match the admin_level
+         * filter. Relations that are not marked as complete afterwards are
+         * skipped by the reader.
+         */
+        osmium::memory::Buffer m_relation_copies{ 1024, osmium::memory::Buffer::auto_grow::yes };
+
+        /**
+         * The ids of the relations that matched the level filter, but whose
+         * member ways were not all found in the way pass.
+         */
+        std::vector<osmium::object_id_type> m_incomplete_relations;
+
+        /* Helper Methods */
+
+        /**
+         * Parse the admin_level of an object.
+         *
+         * @param object The osmium object
+         * @returns      The admin_level or 0 if the object has no valid
+         *               admin_level
+         */
+        static model::level_type level(const osmium::OSMObject& object)
+        {
+            const char* value = object.tags().get_value_by_key("admin_level");
+            if (value == nullptr || *value == '\0')
+            {
+                return 0;
+            }
+            char* end;
+            long level = std::strtol(value, &end, 10);
+            return *end == '\0' ? static_cast<model::level_type>(level) : 0;
+        }
+
+        /**
+         * Mark a way and its referenced nodes for insertion and copy the way
+         * to the way buffer if it was not marked already.
+         */
+        void mark_way(const osmium::Way& way)
+        {
+            if (m_matching_ids(osmium::item_type::way).get(way.positive_id()))
+            {
+                return;
+            }
+            // Mark the way for insertion
+            m_matching_ids(osmium::item_type::way).set(way.positive_id());
+            m_ways.add_item(way);
+            m_ways.commit();
+            // Mark the referenced nodes for insertion
+            for (const osmium::NodeRef& nr : way.nodes())
+            {
+                if (nr.ref() != 0)
+                {
+                    m_matching_ids(osmium::item_type::node).set(nr.positive_ref());
+                }
+            }
+        }
+
+    public:
+
+        /* Constructors */
+
+        BoundaryIdManager(const std::set<model::level_type>& levels) : m_levels(levels) {}
+
+        /* Accessors */
+
+        /**
+         * Replace the admin_level filter. This has to happen before
+         * prepare_for_lookup() is called.
+         */
+        void levels(const std::set<model::level_type>& levels)
+        {
+            m_levels = levels;
+        }
+
+        const nwr_array& matching_ids() const
+        {
+            return m_matching_ids;
+        }
+
+        /**
+         * Retrieve the marked ids, e.g. to move them out of the manager
+         * before it is destroyed.
+         */
+        nwr_array& matching_ids()
+        {
+            return m_matching_ids;
+        }
+
+        osmium::memory::Buffer& ways()
+        {
+            return m_ways;
+        }
+
+        osmium::memory::Buffer& relations()
+        {
+            return m_relation_copies;
+        }
+
+        const std::vector<osmium::object_id_type>& incomplete_relations() const
+        {
+            return m_incomplete_relations;
+        }
+
+        /* Methods */
+
+        /**
+         * Build the set of member way ids of the relations that match the
+         * admin_level filter. This has to be called after the relation pass
+         * and before the way pass.
+         *
+         * Time complexity: Linear
+         */
+        void prepare_for_lookup()
+        {
+            for (const RelationEntry& entry : m_relations)
+            {
+                if (!m_levels.count(entry.level))
+                {
+                    continue;
+                }
+                for (std::size_t i = entry.begin; i < entry.end; i++)
+                {
+                    m_member_ways.set(m_members.at(i));
+                }
+            }
+        }
+
+        /**
+         * Mark the relations that match the admin_level filter and whose
+         * member ways were all found in the way pass. This has to be called
+         * after the way pass.
+         *
+         * Time complexity: Linear
+         */
+        void complete()
+        {
+            const auto& way_ids = m_matching_ids(osmium::item_type::way);
+            for (const RelationEntry& entry : m_relations)
+            {
+                if (!m_levels.count(entry.level))
+                {
+                    continue;
+                }
+                bool complete = true;
+                for (std::size_t i = entry.begin; i < entry.end && complete; i++)
+                {
+                    complete = way_ids.get(m_members.at(i));
+                }
+                if (complete)
+                {
+                    m_matching_ids(osmium::item_type::relation).set(entry.id);
+                }
+                else
+                {
+                    m_incomplete_relations.push_back(entry.id);
+                }
+            }
+            // The relation entries are not needed anymore
+            m_relations = {};
+            m_members = {};
+            m_member_ways.clear();
+        }
+
+        /* Osmium Methods */
+
+        /**
+         * Record the member way ids of all relations tagged with
+         * type=multipolygon or type=boundary with at least one way member.
+         * The admin_level is recorded with the relation, so that the filter
+         * can still be changed after the relation pass.
+         */
+        void relation(const osmium::Relation& relation)
+        {
+            const char* type = relation.tags().get_value_by_key("type");
+
+            // Ignore relations without "type" tag
+            if (type == nullptr)
+            {
+                return;
+            }
+            if (std::strcmp(type, "multipolygon") && std::strcmp(type, "boundary"))
+            {
+                return;
+            }
+            model::level_type relation_level = level(relation);
+            if (relation_level == 0)
+            {
+                return;
+            }
+
+            // Record the member way ids
+            std::size_t begin = m_members.size();
+            for (const osmium::RelationMember& member : relation.members())
+            {
+                if (member.type() == osmium::item_type::way && member.ref() != 0)
+                {
+                    m_members.push_back(member.positive_ref());
+                }
+            }
+            if (m_members.size() > begin)
+            {
+                m_relations.push_back(RelationEntry{ relation.id(), relation_level, begin, m_members.size() });
+                // Copy the relation if it matches the current filter, which
+                // contains all levels if the level is detected later.
+                if (m_levels.count(relation_level))
+                {
+                    m_relation_copies.add_item(relation);
+                    m_relation_copies.commit();
+                }
+            }
+        }
+
+        /**
+         * Mark the member ways of the recorded relations and the closed
+         * ways with a matching admin_level.
+         */
+        void way(const osmium::Way& way)
+        {
+            if (m_member_ways.get(way.positive_id())
+                || (BoundaryManager::is_polygon(way) && m_levels.count(level(way))))
+            {
+                mark_way(way);
+            }
+        }
+
+    };
+
+}
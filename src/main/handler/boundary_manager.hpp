@@ -1,7 +1,10 @@
+#pragma once
+
 #include <set>
 #include <string>
 
 #include <osmium/index/id_set.hpp>
+#include <osmium/memory/buffer.hpp>
 #include <osmium/index/nwr_array.hpp>
 #include <osmium/index/relations_map.hpp>
 #include <osmium/osm/way.hpp>
@@ -25,12 +28,14 @@ namespace handler
      */
     class BoundaryManager : public osmium::relations::RelationsManager<BoundaryManager, false, true, false>
     {
-    protected:
+    public:
 
         /* Types */
 
         using nwr_array = osmium::nwr_array<osmium::index::IdSetDense<osmium::unsigned_object_id_type>>;
 
+    protected:
+
         /* Members */   
 
         /**
@@ -43,12 +48,54 @@ namespace handler
         */
         nwr_array m_matching_ids;
 
+        /**
+         * The copies of the marked ways. Ways are copied as soon as they are
+         * marked, which allows the reader to skip them in later passes
+         * through the input file.
+         */
+        osmium::memory::Buffer m_ways{ 1024, osmium::memory::Buffer::auto_grow::yes };
+
+        /**
+         * The copies of the completed relations. Relations are copied from
+         * the stash when they are completed, so that the reader does not
+         * have to decode them again.
+         */
+        osmium::memory::Buffer m_relation_copies{ 1024, osmium::memory::Buffer::auto_grow::yes };
+
         /* Methods */
 
+        /**
+         * Mark a way and its referenced nodes for insertion and copy the way
+         * to the way buffer if it was not marked already.
+         */
+        void mark_way(const osmium::Way& way)
+        {
+            if (m_matching_ids(osmium::item_type::way).get(way.positive_id()))
+            {
+                return;
+            }
+            // Mark the way for insertion
+            m_matching_ids(osmium::item_type::way).set(way.positive_id());
+            m_ways.add_item(way);
+            m_ways.commit();
+            // Mark the referenced nodes for insertion
+            for (const osmium::NodeRef& nr : way.nodes())
+            {
+                if (nr.ref() != 0)
+                {
+                    m_matching_ids(osmium::item_type::node).set(nr.positive_ref());
+                }
+            }
+        }
+
+    public:
+
+        /* Static Methods */
+
         /**
          * 
          */
-        bool is_polygon(const osmium::Way& way) const
+        static bool is_polygon(const osmium::Way& way)
         {
             return way.nodes().size() > 3
                 && !way.tags().has_tag("area", "no")
@@ -57,8 +104,6 @@ namespace handler
                 && way.ends_have_same_location();
         }
 
-    public:
-
         /* Constructors */
 
         BoundaryManager() : m_filter(osmium::TagsFilter{ true }) {}
@@ -71,11 +116,40 @@ namespace handler
             return m_filter;
         }
 
+        /**
+         * Replace the tag filter. Relations that were accepted with the
+         * previous filter, but do not match the new one, will be ignored
+         * when they are completed.
+         */
+        void filter(const osmium::TagsFilter& filter)
+        {
+            m_filter = filter;
+        }
+
         const nwr_array& matching_ids() const
         {
             return m_matching_ids;
         }
 
+        /**
+         * Retrieve the marked ids, e.g. to move them out of the manager
+         * before it is destroyed.
+         */
+        nwr_array& matching_ids()
+        {
+            return m_matching_ids;
+        }
+
+        osmium::memory::Buffer& ways()
+        {
+            return m_ways;
+        }
+
+        osmium::memory::Buffer& relations()
+        {
+            return m_relation_copies;
+        }
+
         /* Osmium Methods */
 
         /**
@@ -113,9 +187,15 @@ namespace handler
          */
         void complete_relation(const osmium::Relation& relation)
         {
-            // Mark the relation for insertion
+            // Skip relations that do not match the current filter anymore
+            if (!osmium::tags::match_any_of(relation.tags(), m_filter))
+            {
+                return;
+            }
+            // Mark the relation for insertion and copy it
             m_matching_ids(osmium::item_type::relation).set(relation.id());
-            const char* admin_level = relation.get_value_by_key(admin_level);
+            m_relation_copies.add_item(relation);
+            m_relation_copies.commit();
             // Add the way members and their nodes to the output buffer
             for (const auto& member : relation.members())
             {
@@ -123,17 +203,7 @@ namespace handler
                 {
                     // We should handle ways only at this point
                     assert(member.type() == osmium::item_type::way);
-                    // Mark the way for insertion
-                    const osmium::Way* way = this->get_member_way(member.ref());
-                    m_matching_ids(osmium::item_type::way).set(way->id());
-                    // Mark the referenced nodes for insertion
-                    for (const osmium::NodeRef& nr : way->nodes())
-                    {
-                        if (nr.ref() != 0)
-                        {
-                            m_matching_ids(osmium::item_type::node).set(nr.positive_ref());
-                        }
-                    }
+                    mark_way(*this->get_member_way(member.ref()));
                 }
             }
         }
@@ -151,16 +221,7 @@ namespace handler
             {
                 return;
             }
-            // Mark the way for insertion
-            m_matching_ids(osmium::item_type::way).set(way.id());
-            // Mark the referenced nodes for insertion
-            for (const osmium::NodeRef& nr : way.nodes())
-            {
-                if (nr.ref() != 0)
-                {
-                    m_matching_ids(osmium::item_type::node).set(nr.positive_ref());
-                }
-            }
+            mark_way(way);
         }
 
     };
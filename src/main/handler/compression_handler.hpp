@@ -1,58 +1,94 @@
 #pragma once
 
-#include <set>
+#include <algorithm>
+#include <limits>
+#include <functional>
+#include <queue>
+#include <stack>
+#include <tuple>
+#include <vector>
 
-#include <osmium/handler.hpp>
-#include <osmium/osm/way.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/node_ref_list.hpp>
 
 #include "functions/distance.hpp"
-#include "model/geometry/point.hpp"
+#include "model/id_set.hpp"
 
 namespace handler
 {
 
     /**
-     * A handler that counts the total number of nodes, ways and
-     * relations of an osmium object stream.
+     * The line simplification algorithms of the compression.
+     */
+    enum class CompressionAlgorithm
+    {
+        /**
+         * The Douglas-Peucker algorithm, which removes nodes whose
+         * perpendicular distance is less or equal to the tolerance.
+         */
+        dp,
+
+        /**
+         * The Visvalingam-Whyatt algorithm, which removes nodes whose
+         * effective triangle area is less or equal to the squared tolerance.
+         */
+        vw
+    };
+
+    /**
+     * A class that simplifies node reference lists with the Douglas-Peucker
+     * or the Visvalingam-Whyatt algorithm and collects the ids of the nodes
+     * that can be removed. The nodes themselves are not changed, so the
+     * result has to be applied to the buffer afterwards, e.g. by the
+     * mapmaker::Compressor.
      *
-     * Port of https://github.com/osmcode/libosmium/blob/master/examples/osmium_count.cpp
+     * The class does not detect the junction nodes of shared borders, so it
+     * is not applied to whole ways. The mapmaker::Compressor splits the ways
+     * into arcs between junction nodes and passes each arc to arc(), which
+     * keeps the first and last node. Each worker thread uses its own
+     * handler.
      */
-    class CompressionHandler : public osmium::handler::Handler
+    class CompressionHandler
     {
     protected:
 
         /* Members */
 
         /**
-         *
+         * The distance tolerance in the units of the node locations, i.e.
+         * degrees. Visvalingam-Whyatt uses its square as area threshold.
          */
         double m_tolerance;
 
         /**
-         *
+         * The simplification algorithm.
          */
-        std::set<osmium::object_id_type> m_ignored_nodes;
+        CompressionAlgorithm m_algorithm = CompressionAlgorithm::dp;
 
         /**
-         *  The compression result array of node indices that indicates
-         *  which nodes should be kept or removed.
+         *  The compression result set of node ids that indicates which
+         *  nodes should be removed. The node ids are expected to be dense,
+         *  e.g. renumbered by the mapmaker::Renumberer.
          */
-        std::set<osmium::object_id_type> m_removed_nodes;
+        model::IdSet m_removed_nodes;
+
+        /**
+         * The coordinate arrays of the polyline that is currently
+         * compressed, which are reused for all polylines.
+         */
+        std::vector<double> m_x;
+        std::vector<double> m_y;
 
     public:
 
         /* Constructors */
 
-        CompressionHandler(double tolerance) : m_tolerance(tolerance) {}
-
-        CompressionHandler(double tolerance, const std::set<osmium::object_id_type>& ignored_nodes)
-            : m_tolerance(tolerance), m_ignored_nodes(ignored_nodes) {}
+        CompressionHandler(double tolerance, CompressionAlgorithm algorithm = CompressionAlgorithm::dp)
+            : m_tolerance(tolerance), m_algorithm(algorithm) {}
 
         /* Accessors */
 
-        const std::set<osmium::object_id_type>& removed_nodes() const
+        const model::IdSet& removed_nodes() const
         {
             return m_removed_nodes;
         };
@@ -61,55 +97,66 @@ namespace handler
 
         /* Helper Methods */
 
+        /**
+         * Unpack the locations of a part of a node reference list into the
+         * coordinate arrays, so that the distance calculations work on
+         * contiguous doubles instead of converting the fixed-point locations
+         * for every distance.
+         *
+         * Time complexity: Linear
+         */
+        void unpack(const osmium::NodeRefList& nodes, std::size_t first, std::size_t last)
+        {
+            m_x.resize(last - first + 1);
+            m_y.resize(last - first + 1);
+            for (std::size_t i = first; i <= last; i++)
+            {
+                m_x[i - first] = nodes[i].lon();
+                m_y[i - first] = nodes[i].lat();
+            }
+        }
+
         /**
         * Compresses a list of nodes with the Douglas-Peucker-Algorithm.
         * This method implements the iterative version of the algorithm,
         * as the recursive method initializes multiple new collections
         * that will be destroyed by the garbage collector anyway.
         *
+        * The polylines on the stack never overlap, so none of the nodes
+        * between their start and end node was removed already.
+        *
         * For more information on the original algorithm, refer to
         * https://en.wikipedia.org/wiki/Ramer%E2%80%93Douglas%E2%80%93Peucker_algorithm
         *
         * @param nodes     The node reference list
+        * @param first     The index of the first node of the polyline
+        * @param last      The index of the last node of the polyline
         * @param tolerance The compression distance tolerance (epsilon)
         *
         * Time complexity: Log-Linear (Average-case), Quadratic (Worst-case)
         */
-        inline void douglas_peucker(const osmium::NodeRefList& nodes, double tolerance)
+        inline void douglas_peucker(const osmium::NodeRefList& nodes, std::size_t first, std::size_t last, double tolerance)
         {
-            // Create the index stack for the iterative version
-            // of the algorithm
+            unpack(nodes, first, last);
+
+            // Create the index stack for the iterative version of the
+            // algorithm. The indices refer to the coordinate arrays.
             std::stack<std::pair<std::size_t, std::size_t>> stack;
-            stack.push(std::make_pair(0, nodes.size() - 1));
+            stack.push(std::make_pair(0, last - first));
 
             while (!stack.empty())
             {
                 // Get the current start and end index
                 auto [start, end] = stack.top();
                 stack.pop();
+                if (end <= start + 1)
+                {
+                    continue;
+                }
 
                 // Find the node with the greatest perpendicular distance to
                 // the line between the current start and end node
-                std::size_t index = start;
-                double d_max = 0.0;
-                for (std::size_t i = start + 1; i < end; i++)
-                {
-                    // Check if node was removed already in another
-                    // iteration
-                    if (!m_removed_nodes.count(nodes[i].ref()))
-                    {
-                        double d = functions::perpendicular_distance(
-                            model::geometry::Point{ nodes[i].lon(), nodes[i].lat() },
-                            model::geometry::Point{ nodes[start].lon(), nodes[start].lat() },
-                            model::geometry::Point{ nodes[end].lon(), nodes[end].lat() }
-                        );
-                        if (d > d_max)
-                        {
-                            index = i;
-                            d_max = d;
-                        }
-                    }
-                }
+                auto [index, d_max] = functions::max_perpendicular_distance(m_x.data(), m_y.data(), start, end);
 
                 // Check if the maximum distance is greater than the upper tolerance
                 if (d_max > tolerance)
@@ -121,26 +168,185 @@ namespace handler
                 else
                 {
                     // Remove all nodes from the current polyline that are between the
-                    // start and end node, except nodes with degree > 2
+                    // start and end node
                     for (std::size_t i = start + 1; i < end; i++)
                     {
-                        osmium::object_id_type n_id = nodes[i].ref();
-                        if (!m_ignored_nodes.count(n_id))
-                        {
-                            m_removed_nodes.insert(n_id);
-                        }
+                        m_removed_nodes.set(nodes[first + i].ref());
+                    }
+                }
+            }
+        }
+
+        /**
+         * Compresses a list of nodes with the Visvalingam-Whyatt algorithm.
+         * The nodes are kept in a linked list and a min-heap ordered by
+         * their effective area, which is the area of the triangle with
+         * their current neighbors. The node with the smallest area is
+         * removed and the areas of its neighbors are updated until the
+         * smallest area exceeds the threshold. Outdated heap entries are
+         * skipped instead of being removed from the heap.
+         *
+         * The effective area of a node is at least the area of the last
+         * removed node, so that the removal order stays monotonic.
+         *
+         * For more information on the original algorithm, refer to
+         * https://en.wikipedia.org/wiki/Visvalingam%E2%80%93Whyatt_algorithm
+         *
+         * @param nodes     The node reference list
+         * @param first     The index of the first node of the polyline
+         * @param last      The index of the last node of the polyline
+         * @param threshold The effective area threshold
+         *
+         * Time complexity: Linearithmic
+         */
+        inline void visvalingam_whyatt(const osmium::NodeRefList& nodes, std::size_t first, std::size_t last, double threshold)
+        {
+            unpack(nodes, first, last);
+            std::size_t size = last - first + 1;
+
+            // Create the linked list of the remaining nodes and their areas
+            std::vector<std::size_t> prev(size);
+            std::vector<std::size_t> next(size);
+            std::vector<double> areas(size, 0.0);
+            auto area = [&](std::size_t i) {
+                return std::abs(
+                    (m_x[prev[i]] - m_x[i]) * (m_y[next[i]] - m_y[i])
+                    - (m_x[next[i]] - m_x[i]) * (m_y[prev[i]] - m_y[i])
+                ) / 2;
+            };
+
+            // Fill the heap with the inner nodes
+            using entry_type = std::pair<double, std::size_t>;
+            std::priority_queue<entry_type, std::vector<entry_type>, std::greater<entry_type>> heap;
+            for (std::size_t i = 0; i < size; i++)
+            {
+                prev[i] = i > 0 ? i - 1 : i;
+                next[i] = i + 1 < size ? i + 1 : i;
+            }
+            for (std::size_t i = 1; i + 1 < size; i++)
+            {
+                areas[i] = area(i);
+                heap.push(std::make_pair(areas[i], i));
+            }
+
+            // Remove the nodes with the smallest effective area
+            std::vector<bool> removed(size, false);
+            double last_area = 0.0;
+            while (!heap.empty())
+            {
+                auto [a, i] = heap.top();
+                heap.pop();
+                if (removed[i] || a != areas[i])
+                {
+                    continue;
+                }
+                if (a > threshold)
+                {
+                    break;
+                }
+                last_area = a;
+                removed[i] = true;
+                next[prev[i]] = next[i];
+                prev[next[i]] = prev[i];
+                for (std::size_t j : { prev[i], next[i] })
+                {
+                    if (j > 0 && j + 1 < size)
+                    {
+                        areas[j] = std::max(area(j), last_area);
+                        heap.push(std::make_pair(areas[j], j));
                     }
                 }
             }
+
+            // Mark the removed nodes
+            for (std::size_t i = 1; i + 1 < size; i++)
+            {
+                if (removed[i])
+                {
+                    m_removed_nodes.set(nodes[first + i].ref());
+                }
+            }
         }
 
     public:
 
-        /* Osmium Methods */
+        /* Methods */
 
-        void way(const osmium::Way& way) noexcept
+        /**
+         * Compress the part of a node reference list between two indices
+         * with the algorithm of the handler. The first and the last node of
+         * the part are kept.
+         *
+         * @param nodes The node reference list
+         * @param first The index of the first node
+         * @param last  The index of the last node
+         *
+         * Time complexity: Log-Linear (Average-case), Quadratic (Worst-case)
+         */
+        void arc(const osmium::NodeRefList& nodes, std::size_t first, std::size_t last)
         {
-            douglas_peucker(way.nodes(), m_tolerance);
+            if (last <= first + 1)
+            {
+                return;
+            }
+            if (m_algorithm == CompressionAlgorithm::vw)
+            {
+                visvalingam_whyatt(nodes, first, last, m_tolerance * m_tolerance);
+            }
+            else
+            {
+                douglas_peucker(nodes, first, last, m_tolerance);
+            }
+        }
+
+        /**
+         * Rank the inner nodes of a part of a node reference list by their
+         * significance. The Douglas-Peucker algorithm is run with tolerance
+         * 0, and each selected node receives the minimum of its distance and
+         * the significance of the node that split its enclosing polyline.
+         * A node is kept by the algorithm with tolerance t if and only if its
+         * significance is greater than t.
+         *
+         * @param nodes        The node reference list
+         * @param first        The index of the first node
+         * @param last         The index of the last node
+         * @param significance The significance of each node indexed by node
+         *                     id, which must be large enough for all inner
+         *                     nodes
+         *
+         * Time complexity: Log-Linear (Average-case), Quadratic (Worst-case)
+         */
+        void rank(const osmium::NodeRefList& nodes, std::size_t first, std::size_t last, std::vector<double>& significance)
+        {
+            if (last <= first + 1)
+            {
+                return;
+            }
+            unpack(nodes, first, last);
+
+            std::stack<std::tuple<std::size_t, std::size_t, double>> stack;
+            stack.push(std::make_tuple(0, last - first, std::numeric_limits<double>::infinity()));
+
+            while (!stack.empty())
+            {
+                auto [start, end, bound] = stack.top();
+                stack.pop();
+                if (end <= start + 1)
+                {
+                    continue;
+                }
+
+                // Find the node with the greatest perpendicular distance to
+                // the line between the current start and end node
+                auto [index, d_max] = functions::max_perpendicular_distance(m_x.data(), m_y.data(), start, end);
+
+                // The node is kept as long as it and all nodes that split
+                // its enclosing polylines exceed the tolerance
+                double value = std::min(d_max, bound);
+                significance.at(nodes[first + index].positive_ref()) = value;
+                stack.push(std::make_tuple(start, index, value));
+                stack.push(std::make_tuple(index, end, value));
+            }
         }
 
     };
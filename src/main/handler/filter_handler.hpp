@@ -1,13 +1,12 @@
 #pragma once
 
-#include <map>
-#include <set>
-
 #include <osmium/handler.hpp>
 #include <osmium/osm/way.hpp>
 #include <osmium/osm/area.hpp>
 #include <osmium/osm/types.hpp>
 
+#include "model/id_set.hpp"
+
 namespace handler
 {
 
@@ -17,19 +16,22 @@ namespace handler
 
         /* Members */
 
-        std::set<osmium::object_id_type> m_ids;
+        model::IdSet m_ids;
 
-        std::set<osmium::object_id_type> m_references;
+        model::IdSet m_references;
 
     public:
 
         /* Constructors */
 
-        FilterReferenceHandler(const std::set<osmium::object_id_type> ids) : m_ids(ids) {}
+        FilterReferenceHandler(model::IdSet&& ids) : m_ids(std::move(ids))
+        {
+            m_ids.prepare_for_lookup();
+        }
 
         /* Accessors */
 
-        const std::set<osmium::object_id_type>& references() const
+        const model::IdSet& references() const
         {
             return m_references;
         };
@@ -48,19 +50,19 @@ namespace handler
 
         void area(const osmium::Area& area) noexcept
         {
-            if (m_ids.count(area.id()))
+            if (m_ids.get(area.id()))
             {
                 for (const osmium::OuterRing& outer : area.outer_rings())
                 {
                     for (const osmium::NodeRef& nr : outer)
                     {
-                        m_references.insert(nr.ref());
+                        m_references.set(nr.ref());
                     }
                     for (const osmium::InnerRing& inner : area.inner_rings(outer))
                     {
                         for (const osmium::NodeRef& nr : outer)
                         {
-                            m_references.insert(nr.ref());
+                            m_references.set(nr.ref());
                         }
                     }
                 }
@@ -83,9 +85,9 @@ namespace handler
         {
             for (const osmium::NodeRef& nr : way.nodes())
             {
-                if (m_ids.count(nr.ref()))
+                if (m_ids.get(nr.ref()))
                 {
-                    m_references.insert(way.id());
+                    m_references.set(way.id());
                 }
             }
         }
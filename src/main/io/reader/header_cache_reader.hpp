@@ -0,0 +1,165 @@
+#pragma once
+
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include <osmium/io/file.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+
+#include "io/reader/reader.hpp"
+#include "model/fingerprint.hpp"
+#include "model/header.hpp"
+#include "util/cache.hpp"
+
+namespace io
+{
+
+    using json = nlohmann::ordered_json;
+
+    /* Constants */
+
+    /**
+     * The extension of the header cache files.
+     */
+    const std::string HEADER_CACHE_EXTENSION = ".header.json";
+
+    /**
+     * The version of the header cache file format. Cache files with another
+     * version are ignored.
+     */
+    const int HEADER_CACHE_VERSION = 1;
+
+    /**
+     * A reader for the header cache file of an OSM file, which is stored next
+     * to the OSM file and contains its previously retrieved header.
+     */
+    class HeaderCacheReader : public Reader<model::Header>
+    {
+    protected:
+
+        /* Members */
+
+        /**
+         * The path to the OSM file of the cache.
+         */
+        fs::path m_input;
+
+        /**
+         * The parsed cache file if it is valid, which is determined once by
+         * the first call of valid() or read(). The validation parses the
+         * file and fingerprints the input, so it is not repeated.
+         */
+        mutable std::optional<json> m_data;
+
+        /**
+         * Indicates if the cache file was validated already.
+         */
+        mutable bool m_validated = false;
+
+    public:
+
+        /* Constructors */
+
+        HeaderCacheReader(fs::path input_path)
+        : Reader<model::Header>(util::cache_path(input_path, HEADER_CACHE_EXTENSION)), m_input(input_path) {}
+
+    protected:
+
+        /* Helper Methods */
+
+        json parse() const
+        {
+            std::ifstream ifs{ m_path.string() };
+            return json::parse(ifs);
+        }
+
+    public:
+
+        /* Methods */
+
+        /**
+         * Checks if the cache file exists and was created for the current
+         * contents of the OSM file. The result is cached together with the
+         * parsed file.
+         */
+        bool valid() const
+        {
+            if (m_validated)
+            {
+                return m_data.has_value();
+            }
+            m_validated = true;
+            if (!fs::exists(m_path))
+            {
+                return false;
+            }
+            try
+            {
+                json data = parse();
+                model::Fingerprint fingerprint = util::fingerprint(m_input);
+                if (data.at("version").get<int>() == HEADER_CACHE_VERSION
+                    && data.at("fingerprint").at("size").get<std::size_t>() == fingerprint.size
+                    && data.at("fingerprint").at("modified").get<std::time_t>() == fingerprint.modified
+                    && data.at("fingerprint").at("hash").get<std::uint64_t>() == fingerprint.hash)
+                {
+                    m_data = std::move(data);
+                }
+            }
+            catch (const std::exception& e)
+            {
+                // Treat malformed cache files as invalid
+            }
+            return m_data.has_value();
+        }
+
+        /* Override Methods */
+
+        model::Header read() override
+        {
+            if (!valid())
+            {
+                throw std::runtime_error("The header cache " + m_path.string() + " is missing or outdated");
+            }
+            const json& data = *m_data;
+
+            // The file format and compression are derived from the file name
+            osmium::io::File file{ m_input.string() };
+
+            // Restore the bounding box, which is invalid if the file contained
+            // no nodes
+            osmium::Box bounds;
+            if (!data.at("bounds").is_null())
+            {
+                const json& b = data.at("bounds");
+                bounds.extend(osmium::Location{ b.at(0).get<std::int32_t>(), b.at(1).get<std::int32_t>() });
+                bounds.extend(osmium::Location{ b.at(2).get<std::int32_t>(), b.at(3).get<std::int32_t>() });
+            }
+
+            // Restore the level distribution
+            std::map<model::level_type, std::size_t> levels;
+            for (const auto& [level, count] : data.at("levels").items())
+            {
+                levels[std::stoi(level)] = count.get<std::size_t>();
+            }
+
+            return model::Header{
+                m_input.string(),
+                file.format(),
+                file.compression(),
+                data.at("fingerprint").at("size").get<std::size_t>(),
+                data.at("nodes").get<std::size_t>(),
+                data.at("ways").get<std::size_t>(),
+                data.at("relations").get<std::size_t>(),
+                bounds,
+                data.at("boundaries").get<std::size_t>(),
+                levels
+            };
+        }
+
+    };
+
+}
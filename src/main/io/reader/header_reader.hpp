@@ -8,7 +8,9 @@
 #include "handler/bounds_handler.hpp"
 #include "handler/count_handler.hpp"
 #include "handler/tag_value_count_handler.hpp"
+#include "io/reader/header_cache_reader.hpp"
 #include "io/reader/reader.hpp"
+#include "io/writer/header_cache_writer.hpp"
 #include "model/header.hpp"
 
 namespace io
@@ -19,20 +21,58 @@ namespace io
      */
     class HeaderReader : public Reader<model::Header>
     {
+    protected:
+
+        /* Members */
+
+        /**
+         * The cache flag. If set to true, the header is loaded from the header
+         * cache file next to the input file if it is valid. Otherwise, the
+         * header of a complete scan is written to the cache file.
+         */
+        bool m_cache = true;
+
+        /**
+         * Indicates if the last header was loaded from the cache file.
+         */
+        bool m_cached = false;
+
     public:
 
         /* Constructors */
 
         HeaderReader(fs::path file_path) : Reader<model::Header>(file_path) {}
 
+        HeaderReader(fs::path file_path, bool cache)
+        : Reader<model::Header>(file_path), m_cache(cache) {}
+
+        /* Accessors */
+
+        bool cached() const
+        {
+            return m_cached;
+        }
+
         /* Override Methods */
 
         model::Header read() override
         {
+            // Load the header from the cache file if it is up to date
+            if (m_cache)
+            {
+                io::HeaderCacheReader cache_reader{ m_path };
+                m_cached = cache_reader.valid();
+                if (m_cached)
+                {
+                    return cache_reader.read();
+                }
+            }
+
             // The Reader is initialized here with an osmium::io::File, but could
-            // also be directly initialized with a file name.
+            // also be directly initialized with a file name. The object
+            // metadata is skipped, as none of the handlers need it.
             osmium::io::File file{ m_path.string() };
-            osmium::io::Reader reader{file};
+            osmium::io::Reader reader{ file, osmium::io::read_meta::no };
 
             // Create the CountHandler that counts the total number of nodes,
             // ways and relations
@@ -59,8 +99,7 @@ namespace io
             // destructor can't throw, you will not see any errors otherwise.
             reader.close();
 
-            // Return results
-            return model::Header{
+            model::Header header{
                 m_path.string(),
                 file.format(),
                 file.compression(),
@@ -72,6 +111,24 @@ namespace io
                 level_count_handler.total(),
                 level_count_handler.counts()
             };
+
+            // Write the header to the cache file. The cache is optional, so
+            // errors (e.g. for read-only directories) are ignored.
+            if (m_cache)
+            {
+                try
+                {
+                    io::HeaderCacheWriter cache_writer{ m_path };
+                    cache_writer.write(model::Header{ header });
+                }
+                catch (const std::exception& e)
+                {
+                    // Ignore
+                }
+            }
+
+            // Return results
+            return header;
         }
 
     };
@@ -1,17 +1,35 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
 #include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/relations/relations_manager.hpp>
 #include <osmium/tags/tags_filter.hpp>
 #include <osmium/io/any_input.hpp>
 
+#include "handler/boundary_id_manager.hpp"
 #include "handler/boundary_manager.hpp"
+#include "handler/tag_value_count_handler.hpp"
 #include "io/reader/reader.hpp"
 #include "model/types.hpp"
 
 namespace io
 {
 
+    /* Constants */
+
+    /**
+     * The estimated number of bytes of a node in an osmium buffer, including
+     * its metadata and the user name.
+     */
+    const std::size_t NODE_SIZE_ESTIMATE = 80;
+
     /**
      * A reader that retrieves the mapdata of an OSM file.
      */
@@ -34,6 +52,20 @@ namespace io
          */
         std::set<model::level_type> m_levels = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
 
+        /**
+         * The level detection flag. If set to true, the most common admin_level
+         * of all relations in the input file is determined during the relation
+         * pass and replaces the specified levels.
+         */
+        bool m_detect_level = false;
+
+        /**
+         * The low memory flag. If set to true, the handler::BoundaryIdManager
+         * is used, which only stores ids instead of stashing the member ways
+         * of the boundary relations.
+         */
+        bool m_low_memory = false;
+
     public:
 
         /* Constructors */
@@ -43,77 +75,298 @@ namespace io
         BoundaryReader(fs::path file_path, const std::set<model::level_type>& levels)
         : Reader<osmium::memory::Buffer>(file_path), m_levels(levels) {}
 
-        /* Override Methods */
+        BoundaryReader(fs::path file_path, bool detect_level)
+        : Reader<osmium::memory::Buffer>(file_path), m_detect_level(detect_level) {}
 
-        osmium::memory::Buffer read() override
+        /* Accessors */
+
+        /**
+         * Retrieve the admin_level filter. If the level detection was enabled,
+         * this contains the detected level after the file was read.
+         */
+        const std::set<model::level_type>& levels() const
         {
-            osmium::io::File file{m_path.string()};
+            return m_levels;
+        }
+
+        /**
+         * Enable or disable the low memory mode, which only stores ids
+         * during the relation and way passes.
+         */
+        void low_memory(bool low_memory)
+        {
+            m_low_memory = low_memory;
+        }
+
+    protected:
 
-            // Prepare the tag filter for the BoundaryManager with the
-            // specified administrative levels
+        /* Helper Methods */
+
+        /**
+         * Create the tag filter for the BoundaryManager with the specified
+         * administrative levels.
+         */
+        osmium::TagsFilter level_filter() const
+        {
             osmium::TagsFilter filter{ false };
             for (const model::level_type& level : m_levels)
             {
                 filter.add_rule(true, "admin_level", std::to_string(level));
             }
+            return filter;
+        }
 
-            // Instantiate the boundary filter, which will extract all
-            // administrative boundary relation ids for the specified 
-            // admin_levelsas as well as the associated way and node ids.
-            handler::BoundaryManager manager{ filter };
-
-            // First pass through the file: Read all relations and pass them to
-            // the boundary manager. This will also filter out any relations that
-            // do not match the filter.
-            osmium::relations::read_relations(file, manager);
-
-            // Second pass through the file: Extract the osmium objects through the
-            // reader and pass them to the boundary manager, such that it can mark
-            // the nodes, ways and relations
-            osmium::io::Reader manager_reader{file};
-            osmium::apply(manager_reader, manager.handler());
-            manager.read();
-            manager_reader.close();
-            
-            // Extract the matching ids from the manager and prepare the result buffer
-            auto matching_ids = manager.matching_ids();
-            osmium::memory::Buffer result{file.size(), osmium::memory::Buffer::auto_grow::yes};
-
-            // If there were relations in the input with members that weren't
-            // part of the input file (which often happens for extracts), write
-            // the IDs of the incomplete relations to stderr.
-            std::vector<osmium::object_id_type> incomplete_relations_ids;
-            manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle) {
-                incomplete_relations_ids.push_back(handle->id());
-            });
-            if (!incomplete_relations_ids.empty())
+        /**
+         * Select the most common level from the specified level counts and
+         * use it as the only level of the filter.
+         *
+         * @param counts The number of relations for each admin_level
+         * @throws       std::runtime_error if no levels were counted
+         */
+        void select_level(const std::map<model::level_type, std::size_t>& counts)
+        {
+            if (counts.empty())
+            {
+                throw std::runtime_error(
+                    "Unable to detect the territory level, as the input file "
+                    "contains no relations with an admin_level"
+                );
+            }
+            auto it = std::max_element(counts.cbegin(), counts.cend(),
+                [](const auto& e1, const auto& e2)
+                {
+                    return e1.second < e2.second;
+                }
+            );
+            m_levels = { it->first };
+        }
+
+        /**
+         * Warn about the relations in the input with members that weren't
+         * part of the input file, which often happens for extracts.
+         */
+        void warn_incomplete(std::size_t count) const
+        {
+            if (count > 0)
             {
                 std::cerr << "[Warning] Skipped missing members for "
-                    << incomplete_relations_ids.size()
+                    << count
                     << " boundaries.\n";
             }
+        }
 
-            // Third pass trough the file: Copy the marked object into the result buffer
-            // through yet another reader. using the matching ids found by the boundary
-            // manager.
-            osmium::io::Reader copy_reader{file};
+        /**
+         * Sort the objects of a buffer by their id, which restores the order
+         * of the input file for objects that were copied out of order.
+         */
+        template <typename TObject>
+        std::vector<const TObject*> sorted(const osmium::memory::Buffer& buffer) const
+        {
+            std::vector<const TObject*> objects;
+            for (const TObject& object : buffer.select<TObject>())
+            {
+                objects.push_back(&object);
+            }
+            std::sort(objects.begin(), objects.end(), [](const TObject* o1, const TObject* o2) {
+                return o1->id() < o2->id();
+            });
+            return objects;
+        }
+
+        /**
+         * Third pass trough the file: Copy the marked nodes into the result
+         * buffer using the specified matching ids. This is the only pass that
+         * decodes the nodes, and it decodes nothing else. The marked ways and
+         * relations, which were already copied in the previous passes, are
+         * appended after the nodes.
+         *
+         * @param file              The input file
+         * @param matching_ids      The ids of the marked nodes, ways and relations
+         * @param marked_ways       The buffer containing the copied ways
+         * @param copied_relations  The buffer containing the copied relations,
+         *                          of which only the marked ones are kept
+         * @returns                 The result buffer
+         */
+        template <typename TIdSets>
+        osmium::memory::Buffer copy(
+            const osmium::io::File& file,
+            const TIdSets& matching_ids,
+            const osmium::memory::Buffer& marked_ways,
+            const osmium::memory::Buffer& copied_relations
+        ) const {
+            // Prepare the result buffer. Its capacity is estimated from the
+            // number of marked nodes and the size of the copied ways and
+            // relations, so that it tracks the size of the extracted data
+            // instead of the input file.
+            osmium::memory::Buffer result{
+                matching_ids(osmium::item_type::node).size() * NODE_SIZE_ESTIMATE
+                    + marked_ways.committed()
+                    + copied_relations.committed()
+                    + osmium::memory::align_bytes,
+                osmium::memory::Buffer::auto_grow::yes
+            };
+
+            osmium::io::Reader copy_reader{ file, osmium::osm_entity_bits::node };
             while (osmium::memory::Buffer buffer = copy_reader.read())
             {
-                // Copy the marked objects
-                for (auto& object : buffer.select<osmium::OSMObject>())
+                // Copy the marked nodes
+                for (const osmium::Node& node : buffer.select<osmium::Node>())
                 {
-                    if (matching_ids(object.type()).get(object.positive_id()))
+                    if (matching_ids(osmium::item_type::node).get(node.positive_id()))
                     {
-                        // Copy element to the buffer
-                        result.add_item(object);
+                        result.add_item(node);
                         result.commit();
                     }
                 }
             }
             copy_reader.close();
 
-            // Close the reader and return the buffer.
-            return std::move(result);
+            // Copy the ways and relations that were collected in the previous
+            // passes. They were copied in the order in which they were marked
+            // or completed, so they are sorted by their id first to restore
+            // the order of the input file.
+            for (const osmium::Way* way : sorted<osmium::Way>(marked_ways))
+            {
+                result.add_item(*way);
+                result.commit();
+            }
+            for (const osmium::Relation* relation : sorted<osmium::Relation>(copied_relations))
+            {
+                if (matching_ids(osmium::item_type::relation).get(relation->positive_id()))
+                {
+                    result.add_item(*relation);
+                    result.commit();
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Read the boundaries with the handler::BoundaryManager, which
+         * stashes the member ways until their relations are complete.
+         */
+        osmium::memory::Buffer read_stashed(const osmium::io::File& file)
+        {
+            // The marked ids and the copied ways and relations are moved out
+            // of the manager, so that its stash is released before the nodes
+            // are read.
+            handler::BoundaryManager::nwr_array matching_ids;
+            osmium::memory::Buffer ways;
+            osmium::memory::Buffer relations;
+            {
+                // Instantiate the boundary filter, which will extract all
+                // administrative boundary relation ids for the specified 
+                // admin_levelsas as well as the associated way and node ids.
+                handler::BoundaryManager manager{ level_filter() };
+
+                // Create a TagValueCountHandler that counts the levels of all
+                // relations in the first pass, which is needed for the level
+                // detection.
+                handler::TagValueCountHandler<model::level_type> level_count_handler{
+                    "admin_level",
+                    osmium::item_type::relation
+                };
+
+                // First pass through the file: Read all relations and pass them
+                // to the boundary manager. This will also filter out any
+                // relations that do not match the filter. The reader only
+                // decodes relations, so PBF blocks with nodes and ways are
+                // skipped by the parser. The manager stashes the relations
+                // and copies them once they are complete, so they are not
+                // decoded again.
+                osmium::io::Reader relation_reader{ file, osmium::osm_entity_bits::relation };
+                osmium::apply(relation_reader, level_count_handler, manager);
+                relation_reader.close();
+                manager.prepare_for_lookup();
+
+                // If the level detection was enabled, the manager has accepted
+                // the relations of all levels so far. Select the most common
+                // level and narrow down the filter before any way is marked,
+                // such that only the relations with the detected level will be
+                // completed.
+                if (m_detect_level)
+                {
+                    select_level(level_count_handler.counts());
+                    manager.filter(level_filter());
+                }
+
+                // Second pass through the file: Extract the ways through the
+                // reader and pass them to the boundary manager, such that it can
+                // mark the nodes, ways and relations. The boundary manager only
+                // needs the ways in this pass, so nodes and relations are not
+                // decoded at all. Marked ways are copied by the manager right
+                // away.
+                osmium::io::Reader manager_reader{ file, osmium::osm_entity_bits::way };
+                osmium::apply(manager_reader, manager.handler());
+                manager.read();
+                manager_reader.close();
+
+                // Count the incomplete relations that match the filter.
+                std::size_t incomplete_relations = 0;
+                manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle) {
+                    if (osmium::tags::match_any_of(handle->tags(), manager.filter()))
+                    {
+                        incomplete_relations++;
+                    }
+                });
+                warn_incomplete(incomplete_relations);
+
+                matching_ids = std::move(manager.matching_ids());
+                ways = std::move(manager.ways());
+                relations = std::move(manager.relations());
+            }
+
+            // Third pass through the file
+            return copy(file, matching_ids, ways, relations);
+        }
+
+        /**
+         * Read the boundaries with the handler::BoundaryIdManager, which
+         * only stores ids and never stashes whole ways.
+         */
+        osmium::memory::Buffer read_ids(const osmium::io::File& file)
+        {
+            handler::BoundaryIdManager manager{ m_levels };
+            handler::TagValueCountHandler<model::level_type> level_count_handler{
+                "admin_level",
+                osmium::item_type::relation
+            };
+
+            // First pass through the file: Record the member way ids of all
+            // boundary relations and copy the relations.
+            osmium::io::Reader relation_reader{ file, osmium::osm_entity_bits::relation };
+            osmium::apply(relation_reader, level_count_handler, manager);
+            relation_reader.close();
+
+            // Narrow down the level filter if the level detection was enabled
+            // before the member way ids are looked up.
+            if (m_detect_level)
+            {
+                select_level(level_count_handler.counts());
+                manager.levels(m_levels);
+            }
+            manager.prepare_for_lookup();
+
+            // Second pass through the file: Mark and copy the member ways and
+            // mark their nodes. Afterwards, the complete relations are marked.
+            osmium::io::Reader way_reader{ file, osmium::osm_entity_bits::way };
+            osmium::apply(way_reader, manager);
+            way_reader.close();
+            manager.complete();
+            warn_incomplete(manager.incomplete_relations().size());
+
+            // Third pass through the file
+            return copy(file, manager.matching_ids(), manager.ways(), manager.relations());
+        }
+
+    public:
+
+        /* Override Methods */
+
+        osmium::memory::Buffer read() override
+        {
+            osmium::io::File file{m_path.string()};
+            return m_low_memory ? read_ids(file) : read_stashed(file);
         }
 
     };
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <osmium/memory/buffer.hpp>
+
+#include "io/reader/reader.hpp"
+#include "model/snapshot.hpp"
+#include "util/hash.hpp"
+
+namespace io
+{
+
+    /* Constants */
+
+    /**
+     * The extension of buffer snapshot files.
+     */
+    const std::string SNAPSHOT_EXTENSION = ".wzbuf";
+
+    /**
+     * The magic bytes at the start of buffer snapshot files.
+     */
+    const char SNAPSHOT_MAGIC[8] = { 'W', 'Z', 'B', 'U', 'F', '\0', '\0', '\0' };
+
+    /**
+     * The version of the buffer snapshot file format. Snapshot files with
+     * another version are rejected.
+     */
+    const std::uint32_t SNAPSHOT_VERSION = 2;
+
+    /**
+     * A reader for buffer snapshot files, which contain the committed bytes
+     * of an osmium buffer as written by the io::SnapshotWriter.
+     *
+     * The file is memory-mapped and its contents are copied into the result
+     * buffer as a single block, so no decoding is necessary. Snapshots are
+     * stored in the native byte order and can only be read on machines with
+     * the same architecture.
+     *
+     * If the snapshot contains a node significance ranking, it is available
+     * through significance() after reading.
+     */
+    class SnapshotReader : public Reader<osmium::memory::Buffer>
+    {
+    protected:
+
+        /* Members */
+
+        /**
+         * The node significance ranking of the snapshot in the order of the
+         * nodes in the buffer, or an empty vector if the snapshot contains
+         * no ranking.
+         */
+        std::vector<double> m_significance;
+
+    public:
+
+        /* Constructors */
+
+        SnapshotReader(fs::path file_path) : Reader<osmium::memory::Buffer>(file_path) {}
+
+        /* Accessors */
+
+        const std::vector<double>& significance() const
+        {
+            return m_significance;
+        }
+
+        /* Override Methods */
+
+        osmium::memory::Buffer read() override
+        {
+            // Map the snapshot file into memory
+            boost::interprocess::file_mapping mapping{ m_path.c_str(), boost::interprocess::read_only };
+            boost::interprocess::mapped_region region{ mapping, boost::interprocess::read_only };
+            const unsigned char* data = static_cast<const unsigned char*>(region.get_address());
+
+            // Verify the snapshot header
+            if (region.get_size() < sizeof(model::SnapshotHeader))
+            {
+                throw std::runtime_error("The snapshot file " + m_path.string() + " is too small.");
+            }
+            model::SnapshotHeader header;
+            std::memcpy(&header, data, sizeof(model::SnapshotHeader));
+            if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+            {
+                throw std::runtime_error("The file " + m_path.string() + " is not a snapshot file.");
+            }
+            if (header.version != SNAPSHOT_VERSION)
+            {
+                throw std::runtime_error(
+                    "The snapshot file " + m_path.string() + " has the unsupported version "
+                    + std::to_string(header.version) + ". Recreate it with the prepare command."
+                );
+            }
+            std::size_t ranks_size = header.ranks * sizeof(double);
+            if (region.get_size() != sizeof(model::SnapshotHeader) + header.size + ranks_size)
+            {
+                throw std::runtime_error("The snapshot file " + m_path.string() + " is truncated.");
+            }
+
+            // Verify the checksum of the buffer data
+            data += sizeof(model::SnapshotHeader);
+            if (util::fnv1a(data, header.size) != header.hash)
+            {
+                throw std::runtime_error("The checksum of the snapshot file " + m_path.string() + " does not match.");
+            }
+
+            // Copy the buffer data into an owned buffer, so that the later
+            // processing steps can modify and extend it.
+            osmium::memory::Buffer buffer{ header.size, osmium::memory::Buffer::auto_grow::yes };
+            std::memcpy(buffer.reserve_space(header.size), data, header.size);
+            buffer.commit();
+
+            // Copy the node significance ranking if the snapshot contains one
+            data += header.size;
+            if (util::fnv1a(data, ranks_size) != header.ranks_hash)
+            {
+                throw std::runtime_error("The checksum of the ranking in the snapshot file " + m_path.string() + " does not match.");
+            }
+            m_significance.resize(header.ranks);
+            std::memcpy(m_significance.data(), data, ranks_size);
+            return buffer;
+        }
+
+    };
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+#include "io/reader/header_cache_reader.hpp"
+#include "io/writer/writer.hpp"
+#include "model/fingerprint.hpp"
+#include "model/header.hpp"
+#include "util/cache.hpp"
+
+namespace io
+{
+
+    using json = nlohmann::ordered_json;
+
+    /**
+     * A writer for the header cache file of an OSM file. The cache file is
+     * stored next to the OSM file and is keyed by the fingerprint of the
+     * OSM file, such that changes of the OSM file invalidate the cache.
+     */
+    class HeaderCacheWriter : public Writer<model::Header>
+    {
+    protected:
+
+        /* Members */
+
+        /**
+         * The path to the OSM file of the cache.
+         */
+        fs::path m_input;
+
+    public:
+
+        /* Constructors */
+
+        HeaderCacheWriter(fs::path input_path)
+        : Writer<model::Header>(util::cache_path(input_path, HEADER_CACHE_EXTENSION)), m_input(input_path) {}
+
+        /* Override Methods */
+
+        void write(model::Header&& header) override
+        {
+            model::Fingerprint fingerprint = util::fingerprint(m_input);
+
+            json data;
+            data["version"] = HEADER_CACHE_VERSION;
+            data["fingerprint"] = json::object();
+            data["fingerprint"]["size"] = fingerprint.size;
+            data["fingerprint"]["modified"] = fingerprint.modified;
+            data["fingerprint"]["hash"] = fingerprint.hash;
+            data["nodes"] = header.nodes;
+            data["ways"] = header.ways;
+            data["relations"] = header.relations;
+            if (header.bounds.valid())
+            {
+                data["bounds"] = json::array({
+                    header.bounds.bottom_left().x(),
+                    header.bounds.bottom_left().y(),
+                    header.bounds.top_right().x(),
+                    header.bounds.top_right().y()
+                });
+            }
+            else
+            {
+                data["bounds"] = nullptr;
+            }
+            data["boundaries"] = header.boundaries;
+            data["levels"] = json::object();
+            for (const auto& [level, count] : header.levels)
+            {
+                data["levels"][std::to_string(level)] = count;
+            }
+
+            std::ofstream ofs{ m_path.string(), std::ios::trunc };
+            ofs << data.dump() << std::endl;
+        }
+
+    };
+
+}
@@ -10,21 +10,49 @@ namespace io
 {
 
     /**
-     * A reader for API configuration JSON files.
+     * A writer for OSM files containing the extracted boundaries.
      */
     class BoundaryWriter : public Writer<osmium::memory::Buffer>
     {
+    protected:
+
+        /* Members */
+
+        /**
+         * The flag for writing the node locations of the ways. If set to
+         * true, the node locations are stored in the way node references,
+         * which allows readers to skip building a location index.
+         */
+        bool m_locations_on_ways = false;
+
+        /**
+         * The flag for writing the object metadata, i.e. the version,
+         * changeset, uid, user and timestamp attributes.
+         */
+        bool m_metadata = true;
+
     public:
 
         /* Constructors */
 
         BoundaryWriter(fs::path file_path) : Writer<osmium::memory::Buffer>(file_path) {}
+
+        BoundaryWriter(fs::path file_path, bool locations_on_ways, bool metadata = true)
+            : Writer<osmium::memory::Buffer>(file_path), m_locations_on_ways(locations_on_ways), m_metadata(metadata) {}
         
         /* Override Methods */
 
         void write(osmium::memory::Buffer&& buffer) override
         {
             osmium::io::File file{m_path.string()};
+            if (m_locations_on_ways)
+            {
+                file.set("locations_on_ways");
+            }
+            if (!m_metadata)
+            {
+                file.set("add_metadata", "false");
+            }
             
             // Create the header and writer
             osmium::io::Header header;
@@ -33,7 +61,7 @@ namespace io
                 file,
                 header,
                 osmium::io::overwrite::allow, 
-                osmium::io::fsync::yes
+                osmium::io::fsync::no
             };
 
             // Write the buffer to the output file contents
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <osmium/memory/buffer.hpp>
+
+#include "io/reader/snapshot_reader.hpp"
+#include "io/writer/writer.hpp"
+#include "model/snapshot.hpp"
+#include "util/hash.hpp"
+
+namespace io
+{
+
+    /**
+     * A writer for buffer snapshot files. The committed bytes of the osmium
+     * buffer are written after a header containing the format version, the
+     * data size and a checksum of the data. An optional node significance
+     * ranking is written after the buffer data.
+     */
+    class SnapshotWriter : public Writer<osmium::memory::Buffer>
+    {
+    protected:
+
+        /* Members */
+
+        /**
+         * The node significance ranking in the order of the nodes in the
+         * buffer.
+         */
+        std::vector<double> m_significance;
+
+    public:
+
+        /* Constructors */
+
+        SnapshotWriter(fs::path file_path) : Writer<osmium::memory::Buffer>(file_path) {}
+
+        /* Accessors */
+
+        /**
+         * Set the node significance ranking, which has to contain one value
+         * for each node of the written buffer in the order of the buffer.
+         */
+        void significance(std::vector<double>&& significance)
+        {
+            m_significance = std::move(significance);
+        }
+
+        /* Override Methods */
+
+        void write(osmium::memory::Buffer&& buffer) override
+        {
+            model::SnapshotHeader header{};
+            std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+            header.version = SNAPSHOT_VERSION;
+            header.size = buffer.committed();
+            header.hash = util::fnv1a(buffer.data(), buffer.committed());
+            header.ranks = m_significance.size();
+            header.ranks_hash = util::fnv1a(m_significance.data(), m_significance.size() * sizeof(double));
+
+            std::ofstream ofs{ m_path.string(), std::ios::binary | std::ios::trunc };
+            ofs.write(reinterpret_cast<const char*>(&header), sizeof(model::SnapshotHeader));
+            ofs.write(reinterpret_cast<const char*>(buffer.data()), buffer.committed());
+            ofs.write(reinterpret_cast<const char*>(m_significance.data()), m_significance.size() * sizeof(double));
+            if (!ofs)
+            {
+                throw std::runtime_error("Unable to write the snapshot file " + m_path.string() + ".");
+            }
+        }
+
+    };
+
+}
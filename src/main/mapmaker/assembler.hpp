@@ -1,38 +1,83 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include <osmium/osm/area.hpp>
 #include <osmium/area/assembler.hpp>
-#include <osmium/area/multipolygon_manager.hpp>
-#include <osmium/handler/node_locations_for_ways.hpp>
-#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <boost/lexical_cast.hpp>
 
+#include "handler/boundary_manager.hpp"
 #include "model/types.hpp"
+#include "util/thread.hpp"
 
 namespace mapmaker
 {
 
+    /**
+     * A class that assembles the boundary relations of an osmium buffer to
+     * areas. The node locations of the ways have to be set already, e.g. by
+     * the mapmaker::Locator.
+     *
+     * All levels are assembled in a single run. The split policy is defined
+     * per level, such that territories can be split into polygons while
+     * bonuses are kept as multipolygons.
+     *
+     * The closed ways and boundary relations are assembled independently by
+     * the osmium::area::Assembler, optionally distributed over multiple
+     * threads. The assembled areas are ordered by their id.
+     */
     class Assembler
     {
     protected:
 
         /* Types */
 
-       /**
-        * The type of index used. This must match the include file above
-        */
-        using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+        /**
+         * An assembly job, which is either a closed way or a boundary
+         * relation with its member ways.
+         */
+        struct Job
+        {
+            osmium::object_id_type id;
+            const osmium::Relation* relation;
+            std::vector<const osmium::Way*> members;
+        };
 
         /**
-         * The location handler always depends on the index type
+         * The byte range of the areas that were assembled for a job in a
+         * worker buffer.
          */
-        using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+        struct Result
+        {
+            osmium::object_id_type id;
+            std::size_t begin;
+            std::size_t end;
+        };
 
         /* Members */
 
         /**
-         * The admin_level filter. Boundary areas with an administrative level
-         * contained in this set will be assembled, while other areas will
-         * be skipped.
+         * The admin_level filter and split policy. Boundary areas with an
+         * administrative level contained in this map will be assembled, while
+         * other areas will be skipped.
+         *
+         * If the split flag of a level is set to true, the assembled
+         * multipolygon areas of this level, which can contain multiple outer
+         * rings, are split into polygon areas, which contain exactly one
+         * outer ring (and n inner rings).
          *
          * OpenStreetMap defines 9 administrative levels from 2 to 11. Yet,
          * it is also possible to use the levels 0, 1 and 12, which are not
@@ -42,26 +87,150 @@ namespace mapmaker
          * https://wiki.openstreetmap.org/wiki/Key:admin_level
          *
          */
-        std::set<model::level_type> m_levels = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+        std::map<model::level_type, bool> m_levels;
 
-       /**
-        * The split flag. If set to true, the assembled multipolygon areas,
-        * which can contain multiple outer rings are split into polygon areas,
-        * which contain exactly one outer ring (and n inner rings).
-        */
-        bool m_split;
+        /**
+         * The number of threads that assemble the boundaries.
+         */
+        std::size_t m_threads = 1;
+
+        /**
+         * The function that maps the id of an assembled area to the area id
+         * of the original OpenStreetMap object, which is used in the names
+         * of unnamed areas. The ids are kept by default.
+         */
+        std::function<osmium::object_id_type(osmium::object_id_type)> m_original_ids = [](osmium::object_id_type id) {
+            return id;
+        };
 
     public:
 
         /* Constructors */
 
-        Assembler() {}
-        Assembler(const std::set<model::level_type>& levels, bool split = false) : m_levels(levels), m_split(split) {}
-            
+        Assembler(const std::map<model::level_type, bool>& levels, std::size_t threads = 1)
+            : m_levels(levels), m_threads(util::thread_count(threads)) {}
+
+        /* Accessors */
+
+        /**
+         * Set the function that maps the ids of assembled areas to the area
+         * ids of the original objects, e.g. after the objects were renumbered
+         * by the mapmaker::Renumberer.
+         */
+        void original_ids(const std::function<osmium::object_id_type(osmium::object_id_type)>& original_ids)
+        {
+            m_original_ids = original_ids;
+        }
+
     protected:
 
         /* Helper Methods */
 
+        /**
+         * Collect the assembly jobs of the buffer. Boundary relations with
+         * member ways that are not contained in the buffer are skipped, and
+         * a warning with their number is written to stderr.
+         *
+         * Time complexity: Linearithmic
+         */
+        std::vector<Job> collect_jobs(const osmium::memory::Buffer& buffer, const osmium::TagsFilter& filter) const
+        {
+            std::vector<Job> jobs;
+
+            // Collect the closed ways that match the filter and create the
+            // way lookup for the relation members.
+            std::unordered_map<osmium::object_id_type, const osmium::Way*> ways;
+            for (const osmium::Way& way : buffer.select<osmium::Way>())
+            {
+                ways.emplace(way.id(), &way);
+                if (handler::BoundaryManager::is_polygon(way) && osmium::tags::match_any_of(way.tags(), filter))
+                {
+                    jobs.push_back(Job{ osmium::object_id_to_area_id(way.id(), osmium::item_type::way), nullptr, { &way } });
+                }
+            }
+
+            // Collect the boundary relations that match the filter together
+            // with their member ways.
+            std::size_t incomplete_relations = 0;
+            for (const osmium::Relation& relation : buffer.select<osmium::Relation>())
+            {
+                const char* type = relation.tags().get_value_by_key("type");
+                if (type == nullptr || (std::strcmp(type, "multipolygon") && std::strcmp(type, "boundary")))
+                {
+                    continue;
+                }
+                if (!osmium::tags::match_any_of(relation.tags(), filter))
+                {
+                    continue;
+                }
+                Job job{ osmium::object_id_to_area_id(relation.id(), osmium::item_type::relation), &relation, {} };
+                bool complete = true;
+                for (const osmium::RelationMember& member : relation.members())
+                {
+                    if (member.type() != osmium::item_type::way)
+                    {
+                        continue;
+                    }
+                    auto it = ways.find(member.ref());
+                    if (it == ways.end())
+                    {
+                        complete = false;
+                        break;
+                    }
+                    job.members.push_back(it->second);
+                }
+                if (!complete)
+                {
+                    incomplete_relations++;
+                }
+                else if (!job.members.empty())
+                {
+                    jobs.push_back(std::move(job));
+                }
+            }
+
+            // If there were boundary relations in the input with members that
+            // weren't part of the input file (which often happens for extracts),
+            // write the number of the incomplete relations to stderr.
+            if (incomplete_relations > 0)
+            {
+                std::cerr << "[Warning] Skipped missing members for "
+                          << incomplete_relations
+                          << " boundaries.\n";
+            }
+            return jobs;
+        }
+
+        /**
+         * Copy a relation without its non-way members to the specified
+         * buffer, so that its members match the member ways that are passed
+         * to the osmium assembler.
+         *
+         * Time complexity: Linear
+         */
+        const osmium::Relation& way_member_relation(osmium::memory::Buffer& buffer, const osmium::Relation& relation) const
+        {
+            {
+                osmium::builder::RelationBuilder relation_builder{ buffer };
+                relation_builder.set_id(relation.id())
+                    .set_version(relation.version())
+                    .set_changeset(relation.changeset())
+                    .set_timestamp(relation.timestamp())
+                    .set_uid(relation.uid())
+                    .set_user(relation.user())
+                    .add_item(relation.tags());
+                osmium::builder::RelationMemberListBuilder members_builder{ relation_builder };
+                for (const osmium::RelationMember& member : relation.members())
+                {
+                    if (member.type() == osmium::item_type::way)
+                    {
+                        members_builder.add_member(member.type(), member.ref(), member.role());
+                    }
+                }
+            }
+            return buffer.get<osmium::Relation>(buffer.commit());
+        }
+
         void create_area_from_ring(osmium::memory::Buffer& buffer, const osmium::Area& area, const osmium::OuterRing& ring, osmium::object_id_type id, std::string name)
         {
             // Create a new area from the specified outer ring by copying all
@@ -104,74 +273,134 @@ namespace mapmaker
 
         /* Methods */
 
-        void run(osmium::memory::Buffer& buffer)
+        /**
+         * Assemble the boundaries of the buffer into areas. The areas are
+         * returned in their own buffer, so that later stages can iterate them
+         * without skipping the raw objects, and the raw objects can be
+         * released once they are not needed anymore.
+         *
+         * @param buffer The osmium buffer with located ways
+         * @returns      The buffer containing the assembled areas
+         *
+         * Time complexity: Linearithmic
+         */
+        osmium::memory::Buffer run(const osmium::memory::Buffer& buffer)
         {
             // Create the default configuration for the osmium assembler.
             osmium::area::Assembler::config_type config;
 
-            // Prepare the tag filter for the multipolygon manager with the
-            // specified administrative levels.
+            // Prepare the tag filter with the specified administrative levels.
             osmium::TagsFilter filter{ false };
-            for (const model::level_type& level : m_levels)
+            for (const auto& [level, split] : m_levels)
             {
                 filter.add_rule(true, "admin_level", std::to_string(level));
             }
 
-            // Initialize the MultipolygonManager. Its job is to collect all
-            // relations and member ways needed for each area. It then calls an
-            // instance of the osmium::area::Assembler class (with the given config)
-            // to actually assemble one area.
-            osmium::area::MultipolygonManager<osmium::area::Assembler> mp_manager{ config, filter };
-
-            // First pass through the buffer: The manager will read all relation
-            // and filter out any relations that do not match the filter.
-            osmium::apply(buffer, mp_manager);
-            mp_manager.prepare_for_lookup();
+            // Collect the jobs, which are the closed ways and the boundary
+            // relations that match the filter. Each job can be assembled
+            // independently, as the node locations are already set on the
+            // ways.
+            std::vector<Job> jobs = collect_jobs(buffer, filter);
 
-            // The index storing all node locations.
-            index_type index;
-
-            // The handler that stores all node locations in the index and adds them
-            // to the ways.
-            osmium::handler::NodeLocationsForWays<index_type> location_handler{ index };
-            location_handler.ignore_errors();
-
-            // Second pass through the buffer: Assemble the filtered boundary
-            // relations into areas.
-            osmium::apply(buffer, location_handler, mp_manager.handler());
-            osmium::memory::Buffer area_buffer = mp_manager.read();
+            // Assemble the jobs with the worker threads, which take the next
+            // job from the shared job index and write the areas into their
+            // own buffers.
+            std::vector<osmium::memory::Buffer> buffers;
+            std::vector<std::vector<Result>> results(m_threads);
+            for (std::size_t i = 0; i < m_threads; i++)
+            {
+                buffers.emplace_back(1024, osmium::memory::Buffer::auto_grow::yes);
+            }
+            std::atomic<std::size_t> next{ 0 };
+            auto work = [&](std::size_t thread) {
+                osmium::area::Assembler assembler{ config };
+                osmium::memory::Buffer relation_buffer{ 1024, osmium::memory::Buffer::auto_grow::yes };
+                osmium::memory::Buffer& out_buffer = buffers.at(thread);
+                for (std::size_t i = next++; i < jobs.size(); i = next++)
+                {
+                    const Job& job = jobs.at(i);
+                    std::size_t begin = out_buffer.committed();
+                    if (job.relation == nullptr)
+                    {
+                        assembler(*job.members.front(), out_buffer);
+                    }
+                    else
+                    {
+                        assembler(way_member_relation(relation_buffer, *job.relation), job.members, out_buffer);
+                        relation_buffer.clear();
+                    }
+                    results.at(thread).push_back(Result{ job.id, begin, out_buffer.committed() });
+                }
+            };
+            if (m_threads == 1)
+            {
+                work(0);
+            }
+            else
+            {
+                std::vector<std::thread> workers;
+                for (std::size_t i = 0; i < m_threads; i++)
+                {
+                    workers.emplace_back(work, i);
+                }
+                for (std::thread& worker : workers)
+                {
+                    worker.join();
+                }
+            }
 
-            // If there were boundary relations in the input with members that
-            //  weren't part of the input file (which often happens for extracts),
-            // write the IDs of the incomplete relations to stderr.
-            std::vector<osmium::object_id_type> incomplete_relations_ids;
-            mp_manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle) {
-                incomplete_relations_ids.push_back(handle->id());
-                });
-            if (!incomplete_relations_ids.empty())
+            // Merge the areas of the worker buffers in the order of the area
+            // ids, which makes the result independent of the thread count.
+            std::vector<std::pair<Result, std::size_t>> merged;
+            for (std::size_t i = 0; i < m_threads; i++)
             {
-                std::cerr << "[Warning] Skipped missing members for "
-                          << incomplete_relations_ids.size()
-                          << " boundaries.\n";
+                for (const Result& result : results.at(i))
+                {
+                    merged.emplace_back(result, i);
+                }
+            }
+            std::sort(merged.begin(), merged.end(), [](const auto& e1, const auto& e2) {
+                return e1.first.id < e2.first.id;
+            });
+            std::size_t committed = 0;
+            for (const osmium::memory::Buffer& worker_buffer : buffers)
+            {
+                committed += worker_buffer.committed();
+            }
+            osmium::memory::Buffer area_buffer{ committed + osmium::memory::align_bytes, osmium::memory::Buffer::auto_grow::yes };
+            for (const auto& [result, thread] : merged)
+            {
+                std::size_t size = result.end - result.begin;
+                if (size > 0)
+                {
+                    std::memcpy(area_buffer.reserve_space(size), buffers.at(thread).data() + result.begin, size);
+                    area_buffer.commit();
+                }
             }
-      
-            // Add the assembled areas from the area buffer to the input buffer
-            std::size_t offset = 0;
+            buffers.clear();
+
+            // Add the assembled areas to the result buffer and split them if
+            // the split flag of their level is set. Split areas receive
+            // negative ids, which are assigned in the order of the assembled
+            // areas and cannot collide with the positive ids of the areas
+            // created by osmium.
+            osmium::memory::Buffer result{ area_buffer.committed() + osmium::memory::align_bytes, osmium::memory::Buffer::auto_grow::yes };
+            osmium::object_id_type split_id = 0;
             for (const osmium::Area& area : area_buffer.select<osmium::Area>())
             {
-                if (m_split)
+                auto it = m_levels.find(boost::lexical_cast<model::level_type>(area.get_value_by_key("admin_level", "0")));
+                if (it != m_levels.end() && it->second)
                 {
                     // Retrieve the area name
                     std::string name = area.get_value_by_key("name", "");
                     if (name.empty())
                     {
-                        name = "Area" + std::to_string(area.id());
+                        name = "Area" + std::to_string(m_original_ids(area.id()));
                     }
                     if (area.outer_rings().size() == 1)
                     {
-                        create_area_from_ring(buffer, area, *area.outer_rings().begin(), area.id() * (offset + 1), name);
-                        buffer.commit();
-                        ++offset;
+                        create_area_from_ring(result, area, *area.outer_rings().begin(), --split_id, name);
+                        result.commit();
                     }
                     else
                     {
@@ -179,19 +408,19 @@ namespace mapmaker
                         std::size_t i = 1;
                         for (const osmium::OuterRing& outer : area.outer_rings())
                         {
-                            create_area_from_ring(buffer, area, outer, area.id() * (offset + 1), name + ' ' + std::to_string(i));
-                            buffer.commit();
+                            create_area_from_ring(result, area, outer, --split_id, name + ' ' + std::to_string(i));
+                            result.commit();
                             ++i;
-                            ++offset;
                         }
                     }
                 }
                 else
                 {
-                    buffer.add_item(area);
-                    buffer.commit();
+                    result.add_item(area);
+                    result.commit();
                 }
             }
+            return result;
         }
 
     };
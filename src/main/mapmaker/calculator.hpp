@@ -1,10 +1,9 @@
 #pragma once
 
+#include "model/boundary_store.hpp"
 #include "model/geometry/point.hpp"
 #include "model/geometry/rectangle.hpp"
 
-#include "handler/bounds_handler.hpp"
-
 #include "functions/center.hpp"
 
 using namespace model;
@@ -23,15 +22,11 @@ namespace mapmaker
 
         /* Methods */
 
-        geometry::Rectangle<T> run(const osmium::memory::Buffer& buffer) const
+        geometry::Rectangle<T> run(const BoundaryStore& store) const
         {
-            // Prepare the bounds handler that calculates the minimum bounding
-            // box over all nodes in the buffer
-            handler::BoundsHandler bounds_handler{};
-            osmium::apply(buffer, bounds_handler);
-            // Retrieve the calculated bounds and convert them to a rectangle
-            // geometry
-            osmium::Box bounds = bounds_handler.bounds();
+            // Retrieve the bounds from the area envelopes of the store and
+            // convert them to a rectangle geometry
+            osmium::Box bounds = store.envelope();
             return geometry::Rectangle<T>{
                 T(bounds.bottom_left().lon()),
                 T(bounds.bottom_left().lat()),
@@ -1,38 +1,88 @@
 #pragma once
 
-#include <map>
-#include <set>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <osmium/builder/osm_object_builder.hpp>
-#include <osmium/handler/node_locations_for_ways.hpp>
-#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/osm/node.hpp>
 #include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <boost/functional/hash.hpp>
 
 #include "handler/compression_handler.hpp"
+#include "mapmaker/renumberer.hpp"
+#include "model/id_set.hpp"
+#include "util/thread.hpp"
 
 namespace mapmaker
 {
 
+    /**
+     * A class that compresses the ways of an osmium buffer with the
+     * Douglas-Peucker or the Visvalingam-Whyatt algorithm while preserving
+     * the topology of shared borders.
+     *
+     * The ways are split into arcs, which are the maximal node chains
+     * between junction nodes. Arcs that are used by multiple ways are
+     * compressed once, and the result is applied to every way.
+     */
     class Compressor
     {
     protected:
 
         /* Types */
 
-       /**
-        * The type of index used. This must match the include file above
-        */
-        using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
-
         /**
-         * The location handler always depends on the index type
+         * An arc, which is referenced by the node list of a way that contains
+         * it and the indices of its first and last node in that list.
          */
-        using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+        struct Arc
+        {
+            const osmium::NodeRefList* nodes;
+            std::size_t first;
+            std::size_t last;
+        };
 
         /* Members */
 
         double m_tolerance;
 
+        /**
+         * The simplification algorithm.
+         */
+        handler::CompressionAlgorithm m_algorithm = handler::CompressionAlgorithm::dp;
+
+        /**
+         * The number of threads that compress the ways.
+         */
+        std::size_t m_threads = 1;
+
+        /**
+         * The number of nodes before and after the last compression, which
+         * are counted while the compressed buffer is created.
+         */
+        std::size_t m_nodes_before = 0;
+        std::size_t m_nodes_after = 0;
+
+        /**
+         * The number of distinct arcs of the last compression.
+         */
+        std::size_t m_arcs = 0;
+
+        /**
+         * The duration of the last compression in milliseconds.
+         */
+        long m_duration = 0;
+
     public:
 
         /* Constructors */
@@ -40,91 +90,267 @@ namespace mapmaker
         /**
          * Run the compressor on the way and node buffers.
          * Nodes and ways that were removed by the compression will be
-         * removed in the respective buffers.
+         * removed in the respective buffers. The node locations of the ways
+         * have to be set already, e.g. by the mapmaker::Locator.
          *
          * For more information on finding a good tolerance value, refer
          * to https://en.wikipedia.org/wiki/Ramer%E2%80%93Douglas%E2%80%93Peucker_algorithm
          *
+         * The arcs are independent of each other, as the junction nodes are
+         * never removed, so they can be compressed by multiple threads.
+         *
+         * The Visvalingam-Whyatt algorithm uses the squared tolerance as
+         * threshold for the effective areas of the nodes.
+         *
          * @param tolerance The distance epsilon for the Douglas-Peucker-Algorithm.
+         * @param threads   The number of threads
+         * @param algorithm The simplification algorithm
          *
          * Time complexity: Log-Linear (Average-case), Quadratic (Worst-case)
          */
-        Compressor(double tolerance) : m_tolerance(tolerance) {}
-            
-        /* Methods */
+        Compressor(
+            double tolerance,
+            std::size_t threads = 1,
+            handler::CompressionAlgorithm algorithm = handler::CompressionAlgorithm::dp
+        ) : m_tolerance(tolerance), m_algorithm(algorithm), m_threads(util::thread_count(threads)) {}
 
-        void run(osmium::memory::Buffer& buffer)
+    protected:
+
+        /* Helper Methods */
+
+        /**
+         * Find the junction nodes of the ways in the buffer, which are the
+         * first and last nodes of the ways and the nodes that do not have
+         * exactly two distinct neighbors. All other nodes are inner nodes
+         * of exactly one arc.
+         *
+         * @throws std::invalid_argument if the node ids of the buffer are
+         *         not dense, see mapmaker::Renumberer::dense()
+         *
+         * Time complexity: Linear
+         */
+        model::IdSet find_junctions(const osmium::memory::Buffer& buffer) const
         {
-            // If the tolerance is less or equal to zero,
-            // no compression will be applied.
-            if (m_tolerance <= 0)
+            if (!Renumberer::dense(buffer))
             {
-                return;
+                throw std::invalid_argument(
+                    "The compression requires dense node ids, so the buffer "
+                    "has to be renumbered first"
+                );
             }
 
-            // Calculate the degrees for each node in the input buffer. The
-            // resulting map will indicate which nodes should be ignored during
-            // the compression process in order to avoid the creation of holes
-            // between boundaries.
-            std::map<osmium::object_id_type, std::size_t> node_degrees{};
+            // Record up to two distinct neighbors for each node. The node
+            // ids are dense after the renumbering, so the neighbors are
+            // stored in vectors indexed by node id.
+            model::IdSet junctions;
+            std::vector<dense_id_type> first;
+            std::vector<dense_id_type> second;
+            auto add_neighbor = [&](osmium::object_id_type node, osmium::object_id_type neighbor_id) {
+                osmium::unsigned_object_id_type id = static_cast<osmium::unsigned_object_id_type>(node);
+                dense_id_type neighbor = static_cast<dense_id_type>(neighbor_id);
+                if (id >= first.size())
+                {
+                    first.resize(id + 1, 0);
+                    second.resize(id + 1, 0);
+                }
+                if (first[id] == 0 || first[id] == neighbor)
+                {
+                    first[id] = neighbor;
+                }
+                else if (second[id] == 0 || second[id] == neighbor)
+                {
+                    second[id] = neighbor;
+                }
+                else
+                {
+                    junctions.set(node);
+                }
+            };
             for (const osmium::Way& way : buffer.select<osmium::Way>())
             {
-                for (const osmium::NodeRef& nr : way.nodes())
+                const osmium::WayNodeList& nodes = way.nodes();
+                if (nodes.empty())
                 {
-                    // Check if node entry exists in the count map
-                    auto it = node_degrees.find(nr.ref());
-                    if (it == node_degrees.end())
+                    continue;
+                }
+                junctions.set(nodes.front().ref());
+                junctions.set(nodes.back().ref());
+                for (std::size_t i = 1; i < nodes.size(); i++)
+                {
+                    if (nodes[i - 1].ref() != nodes[i].ref())
                     {
-                        it = node_degrees.insert(it, { nr.ref(), 0 });
+                        add_neighbor(nodes[i - 1].ref(), nodes[i].ref());
+                        add_neighbor(nodes[i].ref(), nodes[i - 1].ref());
                     }
-                    it->second += 1;
                 }
             }
 
-            // Ignore nodes that have more than two neighbors.
-            std::set<osmium::object_id_type> ignored_nodes;
-            for (const auto& [id, degree] : node_degrees)
+            // Nodes with less than two distinct neighbors are dead ends.
+            for (std::size_t id = 0; id < first.size(); id++)
             {
-                if (degree > 2)
+                if (first[id] != 0 && second[id] == 0)
                 {
-                    ignored_nodes.insert(id);
+                    junctions.set(id);
                 }
             }
+            return junctions;
+        }
 
-            // The index storing all node locations.
-            index_type index;
+        /**
+         * Split the ways of the buffer at the junction nodes and collect the
+         * distinct arcs. An arc is identified by one of its junctions and
+         * the adjacent inner node, as the inner nodes have exactly two
+         * neighbors. Arcs without inner nodes are skipped, as they cannot be
+         * compressed.
+         *
+         * Time complexity: Linear
+         */
+        std::vector<Arc> collect_arcs(const osmium::memory::Buffer& buffer, const model::IdSet& junctions) const
+        {
+            std::vector<Arc> arcs;
+            std::unordered_set<std::pair<osmium::object_id_type, osmium::object_id_type>, boost::hash<std::pair<osmium::object_id_type, osmium::object_id_type>>> keys;
+            for (const osmium::Way& way : buffer.select<osmium::Way>())
+            {
+                const osmium::WayNodeList& nodes = way.nodes();
+                std::size_t first = 0;
+                for (std::size_t i = 1; i < nodes.size(); i++)
+                {
+                    if (!junctions.get(nodes[i].ref()))
+                    {
+                        continue;
+                    }
+                    if (i > first + 1)
+                    {
+                        // Identify the arc independent of its direction by
+                        // the smaller of its two end keys.
+                        auto key = std::min(
+                            std::make_pair(nodes[first].ref(), nodes[first + 1].ref()),
+                            std::make_pair(nodes[i].ref(), nodes[i - 1].ref())
+                        );
+                        if (keys.insert(key).second)
+                        {
+                            arcs.push_back(Arc{ &nodes, first, i });
+                        }
+                    }
+                    first = i;
+                }
+            }
+            return arcs;
+        }
 
-            // The handler that stores all node locations in the index and adds them
-            // to the ways.
-            osmium::handler::NodeLocationsForWays<index_type> location_handler{ index };
-            location_handler.ignore_errors();
+        /**
+         * Call the function for each arc with the index of the calling
+         * thread. The worker threads take the next arc from a shared arc
+         * index.
+         *
+         * Time complexity: Linear in the number of arcs
+         */
+        template <typename TFunction>
+        void for_each_arc(const std::vector<Arc>& arcs, TFunction&& function) const
+        {
+            std::atomic<std::size_t> next{ 0 };
+            auto work = [&](std::size_t thread) {
+                for (std::size_t i = next++; i < arcs.size(); i = next++)
+                {
+                    function(thread, arcs[i]);
+                }
+            };
+            if (m_threads == 1)
+            {
+                work(0);
+            }
+            else
+            {
+                std::vector<std::thread> workers;
+                for (std::size_t i = 0; i < m_threads; i++)
+                {
+                    workers.emplace_back(work, i);
+                }
+                for (std::thread& worker : workers)
+                {
+                    worker.join();
+                }
+            }
+        }
 
-            // Compress the ways in the buffer using the Douglas-Peucker
-            // algorithm and retrieve the set of removed node ids.
-            handler::CompressionHandler compression_handler{ m_tolerance, ignored_nodes };
-            osmium::apply(buffer, location_handler, compression_handler);
-            std::set<osmium::object_id_type> removed_nodes = compression_handler.removed_nodes();
+        /**
+         * Rebuild the buffer without the removed nodes and node references.
+         *
+         * The result buffer is sized for the committed data of the input
+         * buffer, as the compaction never grows it. Consecutive objects that
+         * are unchanged, i.e. nodes that were kept, ways that reference no
+         * removed node and all other objects, are copied in bulk. Only the
+         * node lists of the changed ways are rebuilt, and removed nodes are
+         * not written at all.
+         *
+         * @param buffer  The osmium buffer
+         * @param removed The predicate that checks if a node id was removed
+         *
+         * Time complexity: Linear
+         */
+        template <typename TPredicate>
+        void rebuild(osmium::memory::Buffer& buffer, TPredicate&& removed)
+        {
+            osmium::memory::Buffer result{ std::max<std::size_t>(buffer.committed(), 1024), osmium::memory::Buffer::auto_grow::yes };
+            m_nodes_before = 0;
+            m_nodes_after = 0;
+
+            // The pending run of unchanged objects, which are stored
+            // contiguously in the input buffer.
+            const unsigned char* run_begin = nullptr;
+            const unsigned char* run_end = nullptr;
+            auto flush = [&]() {
+                if (run_begin != run_end)
+                {
+                    std::size_t size = static_cast<std::size_t>(run_end - run_begin);
+                    std::memcpy(result.reserve_space(size), run_begin, size);
+                    result.commit();
+                }
+                run_begin = nullptr;
+                run_end = nullptr;
+            };
 
-            // Create a new buffer by copying the objects from the old buffer
-            // while ignoring nodes that were marked as removed by the
-            // compression handler.
-            osmium::memory::Buffer result{ 1024, osmium::memory::Buffer::auto_grow::yes };
             for (const auto& object : buffer.select<osmium::OSMObject>())
             {
+                const unsigned char* data = object.data();
+                bool changed = false;
                 switch (object.type())
                 {
                 case osmium::item_type::node:
-                    // Copy the node if it was not marked as removed
-                    if (!removed_nodes.count(object.id()))
+                    ++m_nodes_before;
+                    changed = removed(object.id());
+                    m_nodes_after += !changed;
+                    break;
+                case osmium::item_type::way:
                     {
-                        result.add_item(object);
-                        result.commit();
+                        const osmium::Way& way = static_cast<const osmium::Way&>(object);
+                        changed = std::any_of(way.nodes().cbegin(), way.nodes().cend(), [&](const osmium::NodeRef& nr) {
+                            return removed(nr.ref());
+                        });
                     }
                     break;
-                case osmium::item_type::way:
+                default:
+                    break;
+                }
+
+                // Extend the pending run with the unchanged object
+                if (!changed)
+                {
+                    if (data != run_end)
+                    {
+                        flush();
+                        run_begin = data;
+                    }
+                    run_end = data + object.padded_size();
+                    continue;
+                }
+                flush();
+
+                // Removed nodes are skipped, while changed ways are rebuilt
+                // without the removed node references.
+                if (object.type() == osmium::item_type::way)
+                {
                     {
-                        // Copy the way and rebuild the node reference list
-                        // while ignoring the removed node references.
                         osmium::builder::WayBuilder way_builder{ result };
 
                         // Copy the way attributes and tags
@@ -136,31 +362,177 @@ namespace mapmaker
                             .set_user(object.user())
                             .add_item(object.tags());
 
-                        // Copy the node references and filter the compressed nodes
+                        // Copy the node references including their locations
+                        // and filter the compressed nodes
+                        const osmium::Way& way = static_cast<const osmium::Way&>(object);
+                        osmium::builder::WayNodeListBuilder way_nodes_builder{ way_builder };
+                        for (const osmium::NodeRef& nr : way.nodes())
                         {
-                            const osmium::Way& way = static_cast<const osmium::Way&>(object);
-                            osmium::builder::WayNodeListBuilder way_nodes_builder{ way_builder };
-                            for (const osmium::NodeRef& nr : way.nodes())
+                            if (!removed(nr.ref()))
                             {
-                                if (!removed_nodes.count(nr.ref()))
-                                {
-                                    way_nodes_builder.add_node_ref(nr.ref());
-                                }
+                                way_nodes_builder.add_node_ref(nr);
                             }
                         }
                     }
                     result.commit();
-                    break;
-                default:
-                    result.add_item(object);
-                    result.commit();
                 }
             }
+            flush();
 
             // Swap the old buffer with the resulting compressed buffer
             std::swap(buffer, result);
         }
 
+    public:
+
+        /* Accessors */
+
+        std::size_t nodes_before() const
+        {
+            return m_nodes_before;
+        }
+
+        std::size_t nodes_after() const
+        {
+            return m_nodes_after;
+        }
+
+        /**
+         * Retrieve the number of distinct arcs that were compressed in the
+         * last compression.
+         */
+        std::size_t arcs() const
+        {
+            return m_arcs;
+        }
+
+        /**
+         * Retrieve the duration of the last compression in milliseconds.
+         */
+        long duration() const
+        {
+            return m_duration;
+        }
+            
+        /* Methods */
+
+        void run(osmium::memory::Buffer& buffer)
+        {
+            // If the tolerance is less or equal to zero,
+            // no compression will be applied.
+            if (m_tolerance <= 0)
+            {
+                return;
+            }
+
+            // Find the junction nodes and split the ways into arcs between
+            // them. Each arc is compressed only once, even if it is used by
+            // multiple ways, and its junctions are kept, so that shared
+            // borders stay identical and no holes between boundaries are
+            // created.
+            auto start = std::chrono::steady_clock::now();
+            std::vector<Arc> arcs = collect_arcs(buffer, find_junctions(buffer));
+            m_arcs = arcs.size();
+
+            // Compress the arcs using the selected algorithm. The workers
+            // collect the removed node ids in their own handlers. As the arcs
+            // only share their junctions, the result is independent of the
+            // thread count.
+            std::vector<handler::CompressionHandler> handlers;
+            for (std::size_t i = 0; i < m_threads; i++)
+            {
+                handlers.emplace_back(m_tolerance, m_algorithm);
+            }
+            for_each_arc(arcs, [&](std::size_t thread, const Arc& arc) {
+                handlers.at(thread).arc(*arc.nodes, arc.first, arc.last);
+            });
+
+            // Merge the removed node ids of the workers into a single set.
+            model::IdSet removed_nodes;
+            for (const handler::CompressionHandler& compression_handler : handlers)
+            {
+                removed_nodes.merge(compression_handler.removed_nodes());
+            }
+            handlers.clear();
+
+            rebuild(buffer, [&](osmium::object_id_type id) {
+                return removed_nodes.get(id);
+            });
+            m_duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        /**
+         * Rank the nodes of the buffer by their significance, which is the
+         * largest tolerance at which the Douglas-Peucker algorithm keeps
+         * them. The ranking does not depend on the tolerance, so it can be
+         * stored and used for compressions with different tolerances.
+         *
+         * @param buffer The osmium buffer with located ways
+         * @returns      The significance of each node indexed by node id.
+         *               Junctions and nodes that are not part of any way
+         *               have an infinite significance.
+         *
+         * Time complexity: Log-Linear (Average-case), Quadratic (Worst-case)
+         */
+        std::vector<double> rank(const osmium::memory::Buffer& buffer)
+        {
+            std::vector<Arc> arcs = collect_arcs(buffer, find_junctions(buffer));
+            m_arcs = arcs.size();
+
+            // Size the ranking for the largest node id, so that the workers
+            // can write the significance of the inner nodes of their arcs
+            // concurrently.
+            osmium::unsigned_object_id_type max_id = 0;
+            for (const osmium::Way& way : buffer.select<osmium::Way>())
+            {
+                for (const osmium::NodeRef& nr : way.nodes())
+                {
+                    max_id = std::max(max_id, nr.positive_ref());
+                }
+            }
+            for (const osmium::Node& node : buffer.select<osmium::Node>())
+            {
+                max_id = std::max(max_id, node.positive_id());
+            }
+            std::vector<double> significance(max_id + 1, std::numeric_limits<double>::infinity());
+
+            std::vector<handler::CompressionHandler> handlers;
+            for (std::size_t i = 0; i < m_threads; i++)
+            {
+                handlers.emplace_back(0.0);
+            }
+            for_each_arc(arcs, [&](std::size_t thread, const Arc& arc) {
+                handlers.at(thread).rank(*arc.nodes, arc.first, arc.last, significance);
+            });
+            return significance;
+        }
+
+        /**
+         * Compress the ways of the buffer with a node significance ranking
+         * created by rank(). Nodes with a significance less or equal to the
+         * tolerance are removed, which yields the same result as the
+         * Douglas-Peucker algorithm without recomputing any distances. The
+         * ranking is only valid for the Douglas-Peucker algorithm.
+         *
+         * @param buffer       The osmium buffer
+         * @param significance The significance of each node indexed by node id
+         *
+         * Time complexity: Linear
+         */
+        void run(osmium::memory::Buffer& buffer, const std::vector<double>& significance)
+        {
+            if (m_tolerance <= 0)
+            {
+                return;
+            }
+            auto start = std::chrono::steady_clock::now();
+            rebuild(buffer, [&](osmium::object_id_type id) {
+                osmium::unsigned_object_id_type index = static_cast<osmium::unsigned_object_id_type>(id);
+                return index < significance.size() && significance[index] <= m_tolerance;
+            });
+            m_duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+
     };
 
-}
\ No newline at end of file
+}
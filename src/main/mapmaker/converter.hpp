@@ -6,6 +6,7 @@
 #include <osmium/memory/buffer.hpp>
 
 #include "model/boundary.hpp"
+#include "model/boundary_store.hpp"
 #include "handler/convert_handler.hpp"
 
 using namespace model;
@@ -39,10 +40,10 @@ namespace mapmaker
 
         /* Methods */
 
-		std::map<model::object_id_type, model::Boundary<T>> run(const osmium::memory::Buffer& buffer)
+		std::map<model::object_id_type, model::Boundary<T>> run(const model::BoundaryStore& store)
 		{
             handler::BoundaryConvertHandler<T> convert_handler{ m_transformations };
-            osmium::apply(buffer, convert_handler);
+            store.apply(convert_handler);
             return convert_handler.boundaries();
 		}
 
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <numeric>
+#include <set>
+#include <vector>
 
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
 
+#include "model/boundary_store.hpp"
+#include "model/id_set.hpp"
 #include "model/graph/undirected_graph.hpp"
 
 #include "handler/calculation_handler.hpp"
@@ -31,28 +37,122 @@ namespace mapmaker
         /* Constructors */
 
         AreaFilter(double tolerance) : m_tolerance(tolerance) {}
+
+    protected:
+
+        /* Helper Methods */
+
+        /**
+         * Check whether a ring references any of the specified nodes.
+         *
+         * Time complexity: Linear
+         */
+        bool references_any(const osmium::NodeRefList& ring, const IdSet& nodes) const
+        {
+            return std::any_of(ring.cbegin(), ring.cend(), [&](const osmium::NodeRef& nr) {
+                return nodes.get(nr.ref());
+            });
+        }
+
+        /**
+         * Check whether two bounding boxes overlap.
+         *
+         * Time complexity: Constant
+         */
+        bool overlaps(const osmium::Box& b1, const osmium::Box& b2) const
+        {
+            return b1.valid() && b2.valid()
+                && b1.bottom_left().x() <= b2.top_right().x()
+                && b2.bottom_left().x() <= b1.top_right().x()
+                && b1.bottom_left().y() <= b2.top_right().y()
+                && b2.bottom_left().y() <= b1.top_right().y();
+        }
+
+        /**
+         * Collect the outer rings of an area that do not reference any of
+         * the removed nodes.
+         *
+         * Time complexity: Linear
+         */
+        std::vector<const osmium::OuterRing*> kept_rings(const osmium::Area& area, const IdSet& removed_nodes) const
+        {
+            std::vector<const osmium::OuterRing*> outer_rings;
+            for (const osmium::OuterRing& outer : area.outer_rings())
+            {
+                if (!references_any(outer, removed_nodes))
+                {
+                    outer_rings.push_back(&outer);
+                }
+            }
+            return outer_rings;
+        }
+
+        /**
+         * Rebuild an area with the specified outer rings and their inner
+         * rings in the result buffer.
+         *
+         * Time complexity: Linear
+         */
+        void build_area(osmium::memory::Buffer& result, const osmium::Area& area, const std::vector<const osmium::OuterRing*>& outer_rings) const
+        {
+            {
+                osmium::builder::AreaBuilder area_builder{ result };
+                area_builder.set_id(area.id())
+                    .set_version(area.version())
+                    .set_changeset(area.changeset())
+                    .set_timestamp(area.timestamp())
+                    .set_uid(area.uid())
+                    .set_user(area.user())
+                    .add_item(area.tags());
+                for (const osmium::OuterRing* outer : outer_rings)
+                {
+                    area_builder.add_item(*outer);
+                    for (const osmium::InnerRing& inner : area.inner_rings(*outer))
+                    {
+                        area_builder.add_item(inner);
+                    }
+                }
+            }
+            result.commit();
+        }
+
+    public:
                 
         /* Methods */
 
         /**
-         * Apply the filter on the specified area buffer.
+         * Apply the filter on the specified boundary store.
          * Areas that have a smaller surface area relative to the
          * total surface area than the specified threshold will be
          * removed.
          *
+         * Only the areas contained in the components are filtered, which
+         * are the territories of the neighbor graph. Outer rings of other
+         * areas, e.g. bonuses, that reference the nodes of removed areas are
+         * removed as well.
+         *
          *
          * Time complexity: Linear
          */
         void run(
-            osmium::memory::Buffer& buffer,
+            BoundaryStore& store,
             graph::UndirectedGraph& neighbors,
             std::vector<std::set<osmium::object_id_type>>& components
         ){
-            // Calculate the surface areas of each area in the buffer.
+            // Calculate the surface areas of each area in the store.
             handler::SurfaceAreaHandler surface_handler{};
-            osmium::apply(buffer, surface_handler);
-            std::map<osmium::object_id_type, double> area_surfaces = surface_handler.surfaces();
-            double total_surface = surface_handler.total();
+            store.apply(surface_handler);
+            const std::map<osmium::object_id_type, double>& area_surfaces = surface_handler.surfaces();
+
+            // Calculate the total surface area of the filtered areas
+            double total_surface = 0;
+            for (const std::set<osmium::object_id_type>& component : components)
+            {
+                for (const osmium::object_id_type& id : component)
+                {
+                    total_surface += area_surfaces.at(id);
+                }
+            }
 
             // Filter components by checking if their relative surface area is
             // less than the specified threshold
@@ -88,82 +188,63 @@ namespace mapmaker
                 return;
             }
             
-            // Retrieve the node references for the removed areas
-            handler::AreaNodeFilterHandler node_handler{ removed_areas };
-            osmium::apply(buffer, node_handler);
-            std::set<osmium::object_id_type> removed_nodes = node_handler.references();
-
-            // Retrieve the way references for the removed areas
-            handler::NodeWayFilterHandler way_handler{ removed_nodes };
-            osmium::apply(buffer, way_handler);
-            std::set<osmium::object_id_type> removed_ways = way_handler.references();
-
-            // Remove the marked areas and their associated nodes and ways from
-            // the buffer
-            osmium::memory::Buffer result{ 1024, osmium::memory::Buffer::auto_grow::yes };
-            for (const auto& object : buffer.select<osmium::OSMObject>())
+            // Create the id set of the removed areas, whose representation
+            // is chosen by the range of the area ids.
+            osmium::object_id_type max_id = 0;
+            for (const osmium::object_id_type& id : removed_areas)
+            {
+                max_id = std::max(max_id, id < 0 ? -id : id);
+            }
+            IdSet removed_ids{ removed_areas.size(), max_id };
+            for (const osmium::object_id_type& id : removed_areas)
+            {
+                removed_ids.set(id);
+            }
+
+            // Retrieve the node references and the envelope of the removed
+            // areas
+            handler::AreaNodeFilterHandler node_handler{ std::move(removed_ids) };
+            osmium::Box removed_envelope;
+            for (const osmium::object_id_type& id : removed_areas)
             {
-                switch (object.type())
+                node_handler.area(store.get(id));
+                removed_envelope.extend(store.envelope(id));
+            }
+            const IdSet& removed_nodes = node_handler.references();
+            store.remove(removed_areas);
+
+            // Find the remaining areas with outer rings that reference the
+            // removed nodes. Areas that do not overlap the removed areas are
+            // skipped without looking at their rings.
+            std::set<osmium::object_id_type> emptied_areas;
+            std::vector<osmium::object_id_type> changed_areas;
+            store.for_each([&](const osmium::Area& area) {
+                if (!overlaps(store.envelope(area.id()), removed_envelope))
                 {
-                case osmium::item_type::node:
-                    if (!removed_nodes.count(object.id()))
-                    {
-                        result.add_item(object);
-                        result.commit();
-                    }
-                    break;
-                case osmium::item_type::way:
-                    if (!removed_ways.count(object.id()))
-                    {
-                        if (!removed_areas.count(osmium::object_id_to_area_id(object.id(), object.type())))
-                        {
-                            result.add_item(object);
-                            result.commit();
-                        }
-                    }
-                    break;
-                case osmium::item_type::relation:
-                    if (!removed_areas.count(osmium::object_id_to_area_id(object.id(), object.type())))
-                    {
-                        {
-                            // Rebuild relation without the removed way members
-                            osmium::builder::RelationBuilder relation_builder{ result };
-
-                            // Copy the way attributes and tags
-                            relation_builder.set_id(object.id())
-                                .set_version(object.version())
-                                .set_changeset(object.changeset())
-                                .set_timestamp(object.timestamp())
-                                .set_uid(object.uid())
-                                .set_user(object.user())
-                                .add_item(object.tags());
-
-                            {
-                                // Copy the relation references and filter the removed ways
-                                const osmium::Relation& relation = static_cast<const osmium::Relation&>(object);
-                                osmium::builder::RelationMemberListBuilder members_builder{ relation_builder };
-                                for (const osmium::RelationMember& member : relation.members())
-                                {
-                                    if (member.type() != osmium::item_type::way || !removed_ways.count(member.ref()))
-                                    {
-                                        members_builder.add_member(member.type(), member.ref(), member.role());
-                                    }
-                                }
-                            }
-                        }
-                        result.commit();
-                    }
-                    break;
-                case osmium::item_type::area:
-                    if (!removed_areas.count(object.id()))
-                    {
-                        result.add_item(object);
-                        result.commit();
-                    }
-                    break;
+                    return;
+                }
+                std::size_t kept = kept_rings(area, removed_nodes).size();
+                if (kept == 0)
+                {
+                    emptied_areas.insert(area.id());
                 }
+                else if (kept != area.num_rings().first)
+                {
+                    changed_areas.push_back(area.id());
+                }
+            });
+
+            // Remove the areas without outer rings and replace the changed
+            // areas with copies without the affected outer rings
+            store.remove(emptied_areas);
+            osmium::memory::Buffer area_buffer{ 1024, osmium::memory::Buffer::auto_grow::yes };
+            for (const osmium::object_id_type& id : changed_areas)
+            {
+                const osmium::Area& area = store.get(id);
+                build_area(area_buffer, area, kept_rings(area, removed_nodes));
+                store.replace(area_buffer.get<osmium::Area>(0));
+                area_buffer.clear();
             }
-            std::swap(buffer, result);
 
             // Remove the marked areas and their neighbors from the neighbor
             // graph by creating a filtered copy.
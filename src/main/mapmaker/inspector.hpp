@@ -1,13 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <map>
+#include <optional>
 #include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "model/boundary_store.hpp"
 #include "model/graph/undirected_graph.hpp"
 
 #include "functions/intersect.hpp"
 
 #include "util/insert.hpp"
+#include "util/thread.hpp"
 
 namespace mapmaker
 {
@@ -22,11 +29,16 @@ namespace mapmaker
 
         model::level_type m_level;
 
+        /**
+         * The number of threads that sort the node references.
+         */
+        std::size_t m_threads;
+
     public:
 
         /* Constructors */
 
-        NeighborInspector(model::level_type level) : m_level(level) {};
+        NeighborInspector(model::level_type level, std::size_t threads = 1) : m_level(level), m_threads(threads) {};
 
         /* Methods */
 
@@ -34,20 +46,32 @@ namespace mapmaker
          * Create the neighbor graph for a osmium buffer of areas by checking
          * which areas contain the same node references. If they do so, they are
          * considered to be neighbors. As the neighbor relation is symmetric,
-         * the graph is chosen as undirected.
+         * the graph is chosen as undirected. Only areas with the admin_level
+         * of the inspector are considered.
+         *
+         * The node references are collected as flat (node, area) pairs and
+         * sorted in parallel, so that the areas of each node form a run of
+         * consecutive pairs. The edges are collected from these runs and
+         * deduplicated by sorting before they are inserted into the graph.
          * 
          * @returns The neighbor graph, where vertices represent the areas and
          *          edges represent a neighborship between to areas
          * 
-         * Time complexity: Linear
+         * Time complexity: Linearithmic
          */
-        model::graph::UndirectedGraph run(const osmium::memory::Buffer& buffer)
+        model::graph::UndirectedGraph run(const model::BoundaryStore& store)
         {
             graph::UndirectedGraph neighbors;
             
-            std::map<osmium::object_id_type, std::set<osmium::object_id_type>> references{};
-            for (const osmium::Area& area : buffer.select<osmium::Area>())
-            {
+            std::vector<std::pair<osmium::object_id_type, osmium::object_id_type>> references;
+            const std::string level = std::to_string(m_level);
+            store.for_each([&](const osmium::Area& area) {
+                // Skip areas of other levels
+                if (level != area.get_value_by_key("admin_level", ""))
+                {
+                    return;
+                }
+
                 // Create a vertex for the area in the neighbor graph
                 neighbors.insert_vertex(area.id());
 
@@ -56,30 +80,45 @@ namespace mapmaker
                 {
                     for (const osmium::NodeRef& nr : outer)
                     {
-                        util::insert(references, nr.ref(), area.id());
+                        references.emplace_back(nr.ref(), area.id());
                     }
                     for (const osmium::InnerRing& inner : area.inner_rings(outer))
                     {
                         for (const osmium::NodeRef& nr : inner)
                         {
-                            util::insert(references, nr.ref(), area.id());
+                            references.emplace_back(nr.ref(), area.id());
                         }
                     }
                 }
-            }
-
-            // Create edges in the graph for each two areas that share a common
-            // node.
-            for (const auto& [node, areas] : references)
+            });
+            util::parallel_sort(references.begin(), references.end(), m_threads);
+            references.erase(std::unique(references.begin(), references.end()), references.end());
+
+            // Create edges for each two areas that share a common node, which
+            // are the areas within a run of equal nodes.
+            std::vector<graph::edge_type> edges;
+            for (std::size_t begin = 0, end = 0; begin < references.size(); begin = end)
             {
-                for (auto it1 = areas.begin(); it1 != areas.end(); it1++)
+                while (end < references.size() && references[end].first == references[begin].first)
+                {
+                    end++;
+                }
+                for (std::size_t i = begin; i < end; i++)
                 {
-                    for (auto it2 = std::next(it1, 1); it2 != areas.end(); it2++)
+                    for (std::size_t j = i + 1; j < end; j++)
                     {
-                        neighbors.insert_edge(std::make_pair(*it1, *it2));
+                        edges.emplace_back(references[i].second, references[j].second);
                     }
                 }
             }
+            references = {};
+            util::parallel_sort(edges.begin(), edges.end(), m_threads);
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+            for (const graph::edge_type& edge : edges)
+            {
+                neighbors.insert_edge(edge);
+            }
 
             return neighbors;
         }
@@ -190,7 +229,7 @@ namespace mapmaker
 
         /* Helper Methods */
 
-        object_id_type group(
+        std::optional<object_id_type> group(
             const std::map<object_id_type, Boundary<T>>& boundaries,
             object_id_type id,
             std::set<object_id_type> candidates
@@ -219,8 +258,9 @@ namespace mapmaker
                     }
                 }
             }
-            // No parent found
-            return -1;
+            // No parent found. Split areas have negative ids, so no id can be
+            // used as sentinel.
+            return std::nullopt;
         }
 
     public:
@@ -252,10 +292,10 @@ namespace mapmaker
                 }
                 for (const object_id_type& child : it_h->second)
                 {
-                    object_id_type parent = group(boundaries, child, it_l->second);
-                    if (parent >= 0)
+                    std::optional<object_id_type> parent = group(boundaries, child, it_l->second);
+                    if (parent)
                     {
-                        util::insert(hierarchy, parent, child);
+                        util::insert(hierarchy, *parent, child);
                     }
                 }
             }
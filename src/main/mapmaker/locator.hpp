@@ -0,0 +1,199 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/index/map/all.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace mapmaker
+{
+
+    /**
+     * A class that builds a node location index for an osmium buffer and
+     * stores the node locations in the node references of the ways.
+     *
+     * The index is built once per buffer. Afterwards, all stages that need
+     * node locations can read them directly from the way node references,
+     * as long as they keep the locations when they rebuild ways.
+     *
+     * The file-backed index types "dense_file_array" and "sparse_file_array"
+     * store the index in a temporary file within the index directory, which
+     * is removed again when the locator is destroyed.
+     */
+    class Locator
+    {
+    public:
+
+        /* Types */
+
+        /**
+         * The abstract index type. The actual index implementation is
+         * created by the osmium map factory from the index type name.
+         */
+        using index_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+
+        /**
+         * The location handler always depends on the index type
+         */
+        using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+
+    protected:
+
+        /* Members */
+
+        /**
+         * The name of the index type, e.g. "flex_mem" or "dense_mmap_array".
+         *
+         * For more information on the available index types, refer to
+         * https://osmcode.org/osmium-concepts/#indexes
+         */
+        std::string m_index_type;
+
+        /**
+         * The directory for the index file of file-backed index types.
+         */
+        fs::path m_index_dir;
+
+        /**
+         * The index file of file-backed index types. Empty if the index
+         * type is not file-backed or the index was not built yet.
+         */
+        fs::path m_index_file;
+
+        /**
+         * The node location index.
+         */
+        std::unique_ptr<index_type> m_index;
+
+    public:
+
+        /* Constructors */
+
+        Locator(std::string index_type = "flex_mem", fs::path index_dir = fs::temp_directory_path())
+            : m_index_type(index_type), m_index_dir(index_dir) {}
+
+        Locator(const Locator&) = delete;
+
+        Locator& operator=(const Locator&) = delete;
+
+        /* Destructor */
+
+        ~Locator()
+        {
+            // Close the index before its file is removed
+            m_index.reset();
+            if (!m_index_file.empty())
+            {
+                boost::system::error_code ec;
+                fs::remove(m_index_file, ec);
+            }
+        }
+
+        /* Accessors */
+
+        const std::string& index_type_name() const
+        {
+            return m_index_type;
+        }
+
+        const fs::path& index_file() const
+        {
+            return m_index_file;
+        }
+
+        const index_type& index() const
+        {
+            return *m_index;
+        }
+
+        /* Methods */
+
+        /**
+         * Checks whether the node locations of all way node references in
+         * the buffer are already set, e.g. because the buffer was read from
+         * a file with locations on ways. In this case, the locator does not
+         * have to be run.
+         *
+         * @param buffer The osmium buffer
+         * @returns      True if all way node locations are set
+         *
+         * Time complexity: Linear
+         */
+        static bool located(const osmium::memory::Buffer& buffer)
+        {
+            for (const osmium::Way& way : buffer.select<osmium::Way>())
+            {
+                for (const osmium::NodeRef& nr : way.nodes())
+                {
+                    if (!nr.location().valid())
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Build the location index from the nodes in the buffer and set the
+         * locations of all way node references in the buffer. Nodes have to
+         * be placed before the ways that reference them, which is always the
+         * case for buffers that were created by the io::BoundaryReader.
+         *
+         * @param buffer The osmium buffer
+         *
+         * Time complexity: Linear
+         */
+        void run(osmium::memory::Buffer& buffer)
+        {
+            // Create the index with the specified type. File-backed index
+            // types expect the index file name after the type name.
+            const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+            if (is_file_backed())
+            {
+                m_index_file = m_index_dir / fs::unique_path("locations-%%%%-%%%%-%%%%.idx");
+                m_index = map_factory.create_map(m_index_type + "," + m_index_file.string());
+            }
+            else
+            {
+                m_index = map_factory.create_map(m_index_type);
+            }
+
+            // The handler that stores all node locations in the index and adds them
+            // to the ways.
+            location_handler_type location_handler{ *m_index };
+            location_handler.ignore_errors();
+            osmium::apply(buffer, location_handler);
+        }
+
+    protected:
+
+        /* Helper Methods */
+
+        /**
+         * Checks whether the index type stores the index in a file that
+         * has to be specified when the index is created.
+         *
+         * @returns True if the index type is file-backed
+         *
+         * Time complexity: Constant
+         */
+        bool is_file_backed() const
+        {
+            return m_index_type == "dense_file_array" || m_index_type == "sparse_file_array";
+        }
+
+    };
+
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+namespace mapmaker
+{
+
+    /* Types */
+
+    /**
+     * The type of dense ids. The osmium objects keep their 64-bit id fields,
+     * but after the renumbering all ids fit into 32 bits, so data that is
+     * indexed or keyed by dense ids can be stored with this type.
+     */
+    using dense_id_type = std::uint32_t;
+
+    /**
+     * A class that renumbers the nodes, ways and relations of an osmium
+     * buffer with dense ids, so that later stages can use vectors indexed
+     * by id instead of maps and sets.
+     *
+     * The ids of each type are assigned from 1 to N in the order of the
+     * original ids, as osmium reserves the id 0 for missing references.
+     * Referenced objects that are not contained in the buffer, e.g. missing
+     * relation members, receive ids as well. The original ids are kept in
+     * reverse tables.
+     *
+     * The dense ids are limited to dense_id_type, so that later stages can
+     * store them with 32 bits. They are written to the regular 64-bit id
+     * fields of the osmium objects, as osmium has no narrower id type.
+     */
+    class Renumberer
+    {
+    protected:
+
+        /* Members */
+
+        /**
+         * The reverse tables for nodes, ways and relations. The original id
+         * of the dense id i is stored at index i - 1. The tables are sorted,
+         * so that the dense id of an original id can be found by a binary
+         * search.
+         */
+        std::vector<osmium::object_id_type> m_nodes;
+        std::vector<osmium::object_id_type> m_ways;
+        std::vector<osmium::object_id_type> m_relations;
+
+        /* Helper Methods */
+
+        std::vector<osmium::object_id_type>& table(osmium::item_type type)
+        {
+            switch (type)
+            {
+            case osmium::item_type::node:
+                return m_nodes;
+            case osmium::item_type::way:
+                return m_ways;
+            default:
+                return m_relations;
+            }
+        }
+
+        const std::vector<osmium::object_id_type>& table(osmium::item_type type) const
+        {
+            return const_cast<Renumberer*>(this)->table(type);
+        }
+
+        /**
+         * Sort the table and remove duplicate ids.
+         *
+         * Time complexity: Linearithmic
+         */
+        void finalize(std::vector<osmium::object_id_type>& table)
+        {
+            std::sort(table.begin(), table.end());
+            table.erase(std::unique(table.begin(), table.end()), table.end());
+            table.shrink_to_fit();
+            if (table.size() > std::numeric_limits<dense_id_type>::max())
+            {
+                throw std::runtime_error(
+                    "Unable to renumber " + std::to_string(table.size())
+                    + " objects of the same type with 32-bit dense ids"
+                );
+            }
+        }
+
+        /**
+         * Retrieve the dense id of an original id.
+         *
+         * Time complexity: Logarithmic
+         */
+        osmium::object_id_type dense_id(const std::vector<osmium::object_id_type>& table, osmium::object_id_type id) const
+        {
+            return std::lower_bound(table.cbegin(), table.cend(), id) - table.cbegin() + 1;
+        }
+
+    public:
+
+        /* Constructors */
+
+        Renumberer() {}
+
+        /* Accessors */
+
+        std::size_t nodes() const
+        {
+            return m_nodes.size();
+        }
+
+        std::size_t ways() const
+        {
+            return m_ways.size();
+        }
+
+        std::size_t relations() const
+        {
+            return m_relations.size();
+        }
+
+        /* Methods */
+
+        /**
+         * Check if the node ids of a buffer are dense, i.e. if the largest
+         * node id is not greater than the number of nodes and node
+         * references in the buffer. This holds for every renumbered buffer,
+         * but hardly ever for original OpenStreetMap ids. Stages that index
+         * vectors by node id use this to avoid allocating vectors that are
+         * sized for the largest original id.
+         *
+         * @param buffer The osmium buffer
+         * @returns      True if the node ids are dense
+         *
+         * Time complexity: Linear
+         */
+        static bool dense(const osmium::memory::Buffer& buffer)
+        {
+            std::size_t count = 0;
+            osmium::unsigned_object_id_type max_id = 0;
+            for (const osmium::Node& node : buffer.select<osmium::Node>())
+            {
+                ++count;
+                max_id = std::max(max_id, node.positive_id());
+            }
+            for (const osmium::Way& way : buffer.select<osmium::Way>())
+            {
+                for (const osmium::NodeRef& nr : way.nodes())
+                {
+                    ++count;
+                    max_id = std::max(max_id, nr.positive_ref());
+                }
+            }
+            return max_id <= count && max_id <= std::numeric_limits<dense_id_type>::max();
+        }
+
+        /**
+         * Retrieve the original id of a renumbered object.
+         *
+         * @param type The object type
+         * @param id   The dense id
+         * @returns    The original id
+         *
+         * Time complexity: Constant
+         */
+        osmium::object_id_type original_id(osmium::item_type type, osmium::object_id_type id) const
+        {
+            return table(type).at(id - 1);
+        }
+
+        /**
+         * Retrieve the original area id of an area that was assembled from
+         * renumbered ways or relations.
+         *
+         * @param id The area id
+         * @returns  The area id of the original object
+         *
+         * Time complexity: Constant
+         */
+        osmium::object_id_type original_area_id(osmium::object_id_type id) const
+        {
+            osmium::item_type type = id & 1 ? osmium::item_type::relation : osmium::item_type::way;
+            return osmium::object_id_to_area_id(original_id(type, osmium::area_id_to_object_id(id)), type);
+        }
+
+        /**
+         * Renumber the objects of the buffer in place.
+         *
+         * @param buffer The osmium buffer
+         *
+         * Time complexity: Linearithmic
+         */
+        void run(osmium::memory::Buffer& buffer)
+        {
+            m_nodes.clear();
+            m_ways.clear();
+            m_relations.clear();
+
+            // First pass through the buffer: Collect the ids of all objects
+            // and references.
+            for (const auto& object : buffer.select<osmium::OSMObject>())
+            {
+                table(object.type()).push_back(object.id());
+                if (object.type() == osmium::item_type::way)
+                {
+                    for (const osmium::NodeRef& nr : static_cast<const osmium::Way&>(object).nodes())
+                    {
+                        if (nr.ref() != 0)
+                        {
+                            m_nodes.push_back(nr.ref());
+                        }
+                    }
+                }
+                else if (object.type() == osmium::item_type::relation)
+                {
+                    for (const osmium::RelationMember& member : static_cast<const osmium::Relation&>(object).members())
+                    {
+                        if (member.ref() != 0)
+                        {
+                            table(member.type()).push_back(member.ref());
+                        }
+                    }
+                }
+            }
+            finalize(m_nodes);
+            finalize(m_ways);
+            finalize(m_relations);
+
+            // Second pass through the buffer: Replace the ids of all objects
+            // and references with their dense ids.
+            for (auto& object : buffer.select<osmium::OSMObject>())
+            {
+                object.set_id(dense_id(table(object.type()), object.id()));
+                if (object.type() == osmium::item_type::way)
+                {
+                    for (osmium::NodeRef& nr : static_cast<osmium::Way&>(object).nodes())
+                    {
+                        if (nr.ref() != 0)
+                        {
+                            nr.set_ref(dense_id(m_nodes, nr.ref()));
+                        }
+                    }
+                }
+                else if (object.type() == osmium::item_type::relation)
+                {
+                    for (osmium::RelationMember& member : static_cast<osmium::Relation&>(object).members())
+                    {
+                        if (member.ref() != 0)
+                        {
+                            member.set_ref(dense_id(table(member.type()), member.ref()));
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * Restore the original ids of the objects of a buffer that was
+         * renumbered by the last run.
+         *
+         * @param buffer The renumbered osmium buffer
+         *
+         * Time complexity: Linear
+         */
+        void restore(osmium::memory::Buffer& buffer) const
+        {
+            for (auto& object : buffer.select<osmium::OSMObject>())
+            {
+                object.set_id(original_id(object.type(), object.id()));
+                if (object.type() == osmium::item_type::way)
+                {
+                    for (osmium::NodeRef& nr : static_cast<osmium::Way&>(object).nodes())
+                    {
+                        if (nr.ref() != 0)
+                        {
+                            nr.set_ref(original_id(osmium::item_type::node, nr.ref()));
+                        }
+                    }
+                }
+                else if (object.type() == osmium::item_type::relation)
+                {
+                    for (osmium::RelationMember& member : static_cast<osmium::Relation&>(object).members())
+                    {
+                        if (member.ref() != 0)
+                        {
+                            member.set_ref(original_id(member.type(), member.ref()));
+                        }
+                    }
+                }
+            }
+        }
+
+    };
+
+}
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <stack>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+#include "functions/distance.hpp"
+#include "functions/envelope.hpp"
+#include "model/boundary.hpp"
+#include "model/geometry/ring.hpp"
+#include "model/types.hpp"
+
+using namespace model;
+
+namespace mapmaker
+{
+
+    /**
+     * A class that simplifies the projected ring geometries of boundaries
+     * with the Douglas-Peucker algorithm, using a tolerance in pixels.
+     *
+     * Like the mapmaker::Compressor, the simplifier preserves the topology
+     * of shared borders. The rings are split into arcs between junction
+     * points, which are the first points of the rings and the points that
+     * do not have exactly two distinct neighbors. Points are identified by
+     * their projected coordinates, which are identical for the same node.
+     * Each arc is simplified once, and the result is applied to all rings
+     * that contain it. If a ring would collapse, all of its arcs are kept
+     * unchanged, including in the rings that share them.
+     */
+    template <typename T>
+    class RingSimplifier
+    {
+    protected:
+
+        /* Types */
+
+        using key_type = std::pair<T, T>;
+
+        using hash_type = boost::hash<key_type>;
+
+        /**
+         * The distinct neighbors of a point. A point is a junction if it is
+         * the first point of a ring or if it has more or less than two
+         * distinct neighbors.
+         */
+        struct Neighbors
+        {
+            key_type first;
+            key_type second;
+            std::size_t count = 0;
+            bool junction = false;
+        };
+
+        /**
+         * An arc, which is referenced by a ring that contains it and the
+         * indices of its first and last point in that ring.
+         */
+        struct Arc
+        {
+            const geometry::Ring<T>* ring;
+            std::size_t first;
+            std::size_t last;
+        };
+
+        /* Members */
+
+        /**
+         * The distance tolerance in pixels.
+         */
+        double m_tolerance;
+
+        /**
+         * The number of ring points before and after the last
+         * simplification.
+         */
+        std::size_t m_points_before = 0;
+        std::size_t m_points_after = 0;
+
+    public:
+
+        /* Constructors */
+
+        RingSimplifier(double tolerance) : m_tolerance(tolerance) {}
+
+        /* Accessors */
+
+        std::size_t points_before() const
+        {
+            return m_points_before;
+        }
+
+        std::size_t points_after() const
+        {
+            return m_points_after;
+        }
+
+    protected:
+
+        /* Helper Methods */
+
+        static key_type key(const geometry::Point<T>& point)
+        {
+            return key_type{ point.x(), point.y() };
+        }
+
+        /**
+         * Find the junction points of the rings.
+         *
+         * Time complexity: Linear (Average-case)
+         */
+        std::unordered_set<key_type, hash_type> find_junctions(const std::vector<geometry::Ring<T>*>& rings) const
+        {
+            std::unordered_map<key_type, Neighbors, hash_type> neighbors;
+            auto add_neighbor = [&](const key_type& point, const key_type& neighbor) {
+                Neighbors& entry = neighbors[point];
+                if (entry.count == 0 || (entry.count == 1 && entry.first == neighbor))
+                {
+                    entry.first = neighbor;
+                    entry.count = 1;
+                }
+                else if (entry.count == 1 || entry.second == neighbor)
+                {
+                    entry.second = neighbor;
+                    entry.count = 2;
+                }
+                else if (entry.first != neighbor)
+                {
+                    entry.junction = true;
+                }
+            };
+            std::unordered_set<key_type, hash_type> junctions;
+            for (const geometry::Ring<T>* ring : rings)
+            {
+                if (ring->empty())
+                {
+                    continue;
+                }
+                junctions.insert(key(ring->front()));
+                for (std::size_t i = 1; i < ring->size(); i++)
+                {
+                    if (ring->at(i - 1) != ring->at(i))
+                    {
+                        add_neighbor(key(ring->at(i - 1)), key(ring->at(i)));
+                        add_neighbor(key(ring->at(i)), key(ring->at(i - 1)));
+                    }
+                }
+            }
+            for (const auto& [point, entry] : neighbors)
+            {
+                if (entry.junction || entry.count != 2)
+                {
+                    junctions.insert(point);
+                }
+            }
+            return junctions;
+        }
+
+        /**
+         * Split the rings at the junction points and collect the distinct
+         * arcs with inner points.
+         *
+         * @param rings      The rings
+         * @param junctions  The junction points
+         * @param ring_arcs  The indices of the arcs of each ring, which are
+         *                   filled by this method
+         * @returns          The distinct arcs
+         *
+         * Time complexity: Linear (Average-case)
+         */
+        std::vector<Arc> collect_arcs(
+            const std::vector<geometry::Ring<T>*>& rings,
+            const std::unordered_set<key_type, hash_type>& junctions,
+            std::vector<std::vector<std::size_t>>& ring_arcs
+        ) const {
+            std::vector<Arc> arcs;
+            std::unordered_map<std::pair<key_type, key_type>, std::size_t, boost::hash<std::pair<key_type, key_type>>> keys;
+            ring_arcs.assign(rings.size(), {});
+            for (std::size_t r = 0; r < rings.size(); r++)
+            {
+                const geometry::Ring<T>* ring = rings[r];
+                std::size_t first = 0;
+                for (std::size_t i = 1; i < ring->size(); i++)
+                {
+                    if (!junctions.count(key(ring->at(i))))
+                    {
+                        continue;
+                    }
+                    if (i > first + 1)
+                    {
+                        // Identify the arc independent of its direction by
+                        // the smaller of its two end keys.
+                        auto arc_key = std::min(
+                            std::make_pair(key(ring->at(first)), key(ring->at(first + 1))),
+                            std::make_pair(key(ring->at(i)), key(ring->at(i - 1)))
+                        );
+                        auto [it, inserted] = keys.emplace(arc_key, arcs.size());
+                        if (inserted)
+                        {
+                            arcs.push_back(Arc{ ring, first, i });
+                        }
+                        ring_arcs[r].push_back(it->second);
+                    }
+                    first = i;
+                }
+            }
+            return arcs;
+        }
+
+        /**
+         * Simplify an arc with the iterative Douglas-Peucker algorithm and
+         * collect its removed points with the index of the arc.
+         *
+         * Time complexity: Log-Linear (Average-case), Quadratic (Worst-case)
+         */
+        void simplify(
+            const Arc& arc,
+            std::size_t index,
+            std::vector<double>& x,
+            std::vector<double>& y,
+            std::unordered_map<key_type, std::size_t, hash_type>& removed
+        ) const {
+            x.clear();
+            y.clear();
+            for (std::size_t i = arc.first; i <= arc.last; i++)
+            {
+                x.push_back(arc.ring->at(i).x());
+                y.push_back(arc.ring->at(i).y());
+            }
+
+            std::stack<std::pair<std::size_t, std::size_t>> stack;
+            stack.push(std::make_pair(0, arc.last - arc.first));
+            while (!stack.empty())
+            {
+                auto [start, end] = stack.top();
+                stack.pop();
+                if (end <= start + 1)
+                {
+                    continue;
+                }
+                auto [split, d_max] = functions::max_perpendicular_distance(x.data(), y.data(), start, end);
+                if (d_max > m_tolerance)
+                {
+                    stack.push(std::make_pair(start, split));
+                    stack.push(std::make_pair(split, end));
+                }
+                else
+                {
+                    for (std::size_t i = start + 1; i < end; i++)
+                    {
+                        removed.emplace(key(arc.ring->at(arc.first + i)), index);
+                    }
+                }
+            }
+        }
+
+    public:
+
+        /* Methods */
+
+        /**
+         * Simplify the rings of the boundaries in place. Rings that would
+         * become invalid, i.e. that would have less than three distinct
+         * points, are kept unchanged together with their arcs in all other
+         * rings. The bounds of the boundaries are updated afterwards.
+         *
+         * @param boundaries The projected boundaries
+         *
+         * Time complexity: Log-Linear (Average-case), Quadratic (Worst-case)
+         */
+        void run(std::map<object_id_type, Boundary<T>>& boundaries)
+        {
+            m_points_before = 0;
+            m_points_after = 0;
+            if (m_tolerance <= 0)
+            {
+                return;
+            }
+
+            // Collect the rings of all boundaries
+            std::vector<geometry::Ring<T>*> rings;
+            for (auto& [id, boundary] : boundaries)
+            {
+                for (geometry::Polygon<T>& polygon : boundary.geometry.polygons())
+                {
+                    rings.push_back(&polygon.outer());
+                    for (geometry::Ring<T>& inner : polygon.inners())
+                    {
+                        rings.push_back(&inner);
+                    }
+                }
+            }
+
+            // Simplify each distinct arc once and collect the removed points
+            std::vector<std::vector<std::size_t>> ring_arcs;
+            std::vector<Arc> arcs = collect_arcs(rings, find_junctions(rings), ring_arcs);
+            std::unordered_map<key_type, std::size_t, hash_type> removed;
+            std::vector<double> x;
+            std::vector<double> y;
+            for (std::size_t i = 0; i < arcs.size(); i++)
+            {
+                simplify(arcs[i], i, x, y, removed);
+            }
+
+            // Find the rings that would collapse. A closed ring needs at
+            // least four points to contain three distinct points. All points
+            // that a ring loses are inner points of its arcs, so keeping its
+            // arcs keeps the ring unchanged. Kept arcs only add points to the
+            // other rings, so no other ring collapses because of them.
+            std::vector<bool> kept_arcs(arcs.size(), false);
+            for (std::size_t r = 0; r < rings.size(); r++)
+            {
+                std::size_t size = std::count_if(rings[r]->cbegin(), rings[r]->cend(), [&](const geometry::Point<T>& point) {
+                    return !removed.count(key(point));
+                });
+                if (size < 4)
+                {
+                    for (std::size_t arc : ring_arcs[r])
+                    {
+                        kept_arcs[arc] = true;
+                    }
+                }
+            }
+            for (auto it = removed.begin(); it != removed.end();)
+            {
+                it = kept_arcs[it->second] ? removed.erase(it) : std::next(it);
+            }
+
+            // Remove the points from all rings that contain them, so that
+            // shared arcs are simplified identically in all rings.
+            for (geometry::Ring<T>* ring : rings)
+            {
+                m_points_before += ring->size();
+                ring->erase(
+                    std::remove_if(ring->begin(), ring->end(), [&](const geometry::Point<T>& point) {
+                        return removed.count(key(point)) > 0;
+                    }),
+                    ring->end()
+                );
+                m_points_after += ring->size();
+            }
+
+            // Update the bounds of the simplified boundaries
+            for (auto& [id, boundary] : boundaries)
+            {
+                boundary.bounds = functions::envelope(boundary.geometry);
+            }
+        }
+
+    };
+
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <set>
+#include <string>
+
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/way.hpp>
+
+namespace mapmaker
+{
+
+    /**
+     * A class that strips the metadata and all tags that are not read by
+     * the map creation from the objects of an osmium buffer.
+     *
+     * The version, changeset, uid, user and timestamp attributes of the
+     * objects are dropped, while the node locations, the way node
+     * references including their locations and the relation members are
+     * kept.
+     */
+    class Stripper
+    {
+    protected:
+
+        /* Members */
+
+        /**
+         * The keys of the tags that are kept. All other tags are dropped.
+         */
+        std::set<std::string> m_keys;
+
+    public:
+
+        /* Constructors */
+
+        Stripper(std::set<std::string> keys = { "admin_level", "name", "type", "boundary", "area" }) : m_keys(keys) {}
+
+        /* Methods */
+
+        /**
+         * Run the stripper on the buffer. The stripped objects replace the
+         * objects in the buffer.
+         *
+         * @param buffer The osmium buffer
+         *
+         * Time complexity: Linear
+         */
+        void run(osmium::memory::Buffer& buffer)
+        {
+            // Create a new buffer by rebuilding the objects from the old
+            // buffer without their metadata and the dropped tags.
+            osmium::memory::Buffer result{ buffer.committed(), osmium::memory::Buffer::auto_grow::yes };
+            for (const auto& object : buffer.select<osmium::OSMObject>())
+            {
+                switch (object.type())
+                {
+                case osmium::item_type::node:
+                    {
+                        const osmium::Node& node = static_cast<const osmium::Node&>(object);
+                        osmium::builder::NodeBuilder node_builder{ result };
+                        node_builder.set_id(node.id())
+                            .set_visible(node.visible())
+                            .set_location(node.location());
+                        add_tags(node_builder, node.tags());
+                    }
+                    result.commit();
+                    break;
+                case osmium::item_type::way:
+                    {
+                        const osmium::Way& way = static_cast<const osmium::Way&>(object);
+                        osmium::builder::WayBuilder way_builder{ result };
+                        way_builder.set_id(way.id())
+                            .set_visible(way.visible());
+                        add_tags(way_builder, way.tags());
+
+                        // Copy the node references including their locations
+                        {
+                            osmium::builder::WayNodeListBuilder way_nodes_builder{ way_builder };
+                            for (const osmium::NodeRef& nr : way.nodes())
+                            {
+                                way_nodes_builder.add_node_ref(nr);
+                            }
+                        }
+                    }
+                    result.commit();
+                    break;
+                case osmium::item_type::relation:
+                    {
+                        const osmium::Relation& relation = static_cast<const osmium::Relation&>(object);
+                        osmium::builder::RelationBuilder relation_builder{ result };
+                        relation_builder.set_id(relation.id())
+                            .set_visible(relation.visible());
+                        add_tags(relation_builder, relation.tags());
+
+                        // Copy the relation members including their roles
+                        {
+                            osmium::builder::RelationMemberListBuilder members_builder{ relation_builder };
+                            for (const osmium::RelationMember& member : relation.members())
+                            {
+                                members_builder.add_member(member.type(), member.ref(), member.role());
+                            }
+                        }
+                    }
+                    result.commit();
+                    break;
+                default:
+                    result.add_item(object);
+                    result.commit();
+                }
+            }
+
+            // Swap the old buffer with the resulting stripped buffer
+            std::swap(buffer, result);
+        }
+
+    protected:
+
+        /* Helper Methods */
+
+        /**
+         * Add the tags with a kept key to the object that is currently
+         * built.
+         *
+         * @param builder The object builder
+         * @param tags    The tags of the original object
+         *
+         * Time complexity: Linear
+         */
+        template <typename TBuilder>
+        void add_tags(TBuilder& builder, const osmium::TagList& tags)
+        {
+            osmium::builder::TagListBuilder tags_builder{ builder };
+            for (const osmium::Tag& tag : tags)
+            {
+                if (m_keys.count(tag.key()))
+                {
+                    tags_builder.add_tag(tag.key(), tag.value());
+                }
+            }
+        }
+
+    };
+
+}
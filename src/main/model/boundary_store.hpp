@@ -0,0 +1,237 @@
+#pragma once
+
+#include <cstddef>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/types.hpp>
+
+namespace model
+{
+
+    /**
+     * A store that owns the assembled boundary areas and provides constant
+     * time access to them by their id.
+     *
+     * The areas are kept in a single osmium buffer. For each area, the store
+     * keeps its offset in the buffer and its envelope. Removed areas are
+     * only marked as removed, so that bulk removals do not require a rebuild
+     * of the buffer. Replaced areas are appended to the buffer.
+     */
+    class BoundaryStore
+    {
+    protected:
+
+        /* Members */
+
+        /**
+         * The buffer containing the areas.
+         */
+        osmium::memory::Buffer m_buffer;
+
+        /**
+         * The offsets of the areas in the buffer, in the order of insertion.
+         */
+        std::vector<std::size_t> m_offsets;
+
+        /**
+         * The envelopes of the areas, in the order of insertion.
+         */
+        std::vector<osmium::Box> m_envelopes;
+
+        /**
+         * The removal flags of the areas, in the order of insertion.
+         */
+        std::vector<bool> m_removed;
+
+        /**
+         * The slot index of each area that was not removed, by area id.
+         */
+        std::unordered_map<osmium::object_id_type, std::size_t> m_index;
+
+        /* Helper Methods */
+
+        /**
+         * Register the area at the specified offset in the buffer.
+         *
+         * Time complexity: Linear in the number of area nodes
+         */
+        void insert(std::size_t offset)
+        {
+            const osmium::Area& area = m_buffer.get<osmium::Area>(offset);
+            osmium::Box envelope;
+            for (const osmium::OuterRing& outer : area.outer_rings())
+            {
+                envelope.extend(outer.envelope());
+            }
+            m_index[area.id()] = m_offsets.size();
+            m_offsets.push_back(offset);
+            m_envelopes.push_back(envelope);
+            m_removed.push_back(false);
+        }
+
+        std::size_t slot(osmium::object_id_type id) const
+        {
+            auto it = m_index.find(id);
+            if (it == m_index.end())
+            {
+                throw std::out_of_range("The boundary store contains no area with the id " + std::to_string(id) + ".");
+            }
+            return it->second;
+        }
+
+    public:
+
+        /* Constructors */
+
+        /**
+         * Create the store from a buffer of areas, which is taken over by
+         * the store.
+         *
+         * Time complexity: Linear
+         */
+        BoundaryStore(osmium::memory::Buffer&& buffer) : m_buffer(std::move(buffer))
+        {
+            for (const osmium::Area& area : m_buffer.select<osmium::Area>())
+            {
+                insert(static_cast<std::size_t>(reinterpret_cast<const unsigned char*>(&area) - m_buffer.data()));
+            }
+        }
+
+        /* Accessors */
+
+        /**
+         * Retrieve the number of areas in the store.
+         *
+         * Time complexity: Constant
+         */
+        std::size_t size() const
+        {
+            return m_index.size();
+        }
+
+        bool empty() const
+        {
+            return m_index.empty();
+        }
+
+        bool contains(osmium::object_id_type id) const
+        {
+            return m_index.count(id);
+        }
+
+        /**
+         * Retrieve the area with the specified id.
+         *
+         * Time complexity: Constant
+         */
+        const osmium::Area& get(osmium::object_id_type id) const
+        {
+            return m_buffer.get<osmium::Area>(m_offsets.at(slot(id)));
+        }
+
+        /**
+         * Retrieve the envelope of the outer rings of the area with the
+         * specified id.
+         *
+         * Time complexity: Constant
+         */
+        const osmium::Box& envelope(osmium::object_id_type id) const
+        {
+            return m_envelopes.at(slot(id));
+        }
+
+        /**
+         * Retrieve the envelope of all areas in the store.
+         *
+         * Time complexity: Linear in the number of areas
+         */
+        osmium::Box envelope() const
+        {
+            osmium::Box envelope;
+            for (std::size_t i = 0; i < m_offsets.size(); i++)
+            {
+                if (!m_removed[i])
+                {
+                    envelope.extend(m_envelopes[i]);
+                }
+            }
+            return envelope;
+        }
+
+        /* Methods */
+
+        /**
+         * Call the function for each area in the store in the order of
+         * insertion.
+         *
+         * Time complexity: Linear in the number of areas
+         */
+        template <typename TFunction>
+        void for_each(TFunction&& function) const
+        {
+            for (std::size_t i = 0; i < m_offsets.size(); i++)
+            {
+                if (!m_removed[i])
+                {
+                    function(m_buffer.get<osmium::Area>(m_offsets[i]));
+                }
+            }
+        }
+
+        /**
+         * Apply the area callbacks of the osmium handlers to each area in the
+         * store in the order of insertion.
+         *
+         * Time complexity: Linear in the number of areas
+         */
+        template <typename... THandlers>
+        void apply(THandlers&... handlers) const
+        {
+            for_each([&](const osmium::Area& area) {
+                (handlers.area(area), ...);
+            });
+        }
+
+        /**
+         * Remove the areas with the specified ids from the store. The areas
+         * are only marked as removed and stay in the buffer.
+         *
+         * Time complexity: Linear in the number of removed areas
+         */
+        void remove(const std::set<osmium::object_id_type>& ids)
+        {
+            for (const osmium::object_id_type& id : ids)
+            {
+                auto it = m_index.find(id);
+                if (it != m_index.end())
+                {
+                    m_removed[it->second] = true;
+                    m_index.erase(it);
+                }
+            }
+        }
+
+        /**
+         * Replace the area with the id of the specified area by a copy of
+         * it. The copy is appended to the buffer of the store, so the
+         * specified area must not be contained in the store itself.
+         *
+         * Time complexity: Linear in the number of area nodes
+         */
+        void replace(const osmium::Area& area)
+        {
+            remove({ area.id() });
+            m_buffer.add_item(area);
+            insert(m_buffer.commit());
+        }
+
+    };
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+namespace model
+{
+
+    /**
+     * A container for the values that identify the contents of a file
+     * without reading it completely.
+     */
+    struct Fingerprint
+    {
+        std::size_t size;
+        std::time_t modified;
+        std::uint64_t hash;
+
+        bool operator==(const Fingerprint& other) const
+        {
+            return size == other.size && modified == other.modified && hash == other.hash;
+        }
+
+        bool operator!=(const Fingerprint& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+}
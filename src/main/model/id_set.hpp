@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/osm/types.hpp>
+
+#include "model/types.hpp"
+
+namespace model
+{
+
+    /**
+     * A set of object ids for fast membership tests, which is backed by
+     * either an osmium::index::IdSetDense or an osmium::index::IdSetSmall.
+     *
+     * The dense set stores one bit per id in the id range and is the right
+     * choice if a notable fraction of the range is contained, e.g. for the
+     * renumbered node ids. The small set stores the ids in a sorted vector,
+     * which is cheaper for few ids spread over a large range.
+     *
+     * Negative ids, e.g. of split areas, are supported by mapping them to
+     * odd keys and positive ids to even keys.
+     */
+    class IdSet
+    {
+    public:
+
+        /* Types */
+
+        using key_type = osmium::unsigned_object_id_type;
+
+        /* Constants */
+
+        /**
+         * The number of id range bits per contained id at which the dense
+         * set uses less memory than the small set, which needs 64 bits per
+         * id.
+         */
+        static constexpr std::size_t DENSITY_THRESHOLD = 64;
+
+    protected:
+
+        /* Members */
+
+        bool m_dense;
+
+        /**
+         * The flag that indicates whether the small set is sorted and
+         * unique, such that it can be searched with a binary search.
+         */
+        bool m_sorted = true;
+
+        osmium::index::IdSetDense<key_type> m_dense_set;
+
+        osmium::index::IdSetSmall<key_type> m_small_set;
+
+        /* Helper Methods */
+
+        static key_type key(object_id_type id) noexcept
+        {
+            return id < 0 ? (static_cast<key_type>(-(id + 1)) << 1) | 1 : static_cast<key_type>(id) << 1;
+        }
+
+    public:
+
+        /* Constructors */
+
+        /**
+         * Create an empty id set.
+         *
+         * @param dense The flag that selects the dense representation
+         */
+        explicit IdSet(bool dense = true) : m_dense(dense) {}
+
+        /**
+         * Create an empty id set and choose its representation by the
+         * expected number of ids and the largest absolute id.
+         *
+         * @param count  The expected number of ids
+         * @param max_id The largest absolute id
+         */
+        IdSet(std::size_t count, object_id_type max_id)
+            : m_dense(count * DENSITY_THRESHOLD >= static_cast<std::size_t>(max_id) * 2) {}
+
+        IdSet(const IdSet&) = delete;
+        IdSet& operator=(const IdSet&) = delete;
+
+        IdSet(IdSet&&) = default;
+        IdSet& operator=(IdSet&&) = default;
+
+        /* Accessors */
+
+        bool dense() const noexcept
+        {
+            return m_dense;
+        }
+
+        bool empty() const noexcept
+        {
+            return m_dense ? m_dense_set.empty() : m_small_set.empty();
+        }
+
+        /* Methods */
+
+        /**
+         * Add an id to the set.
+         *
+         * Time complexity: Constant
+         */
+        void set(object_id_type id)
+        {
+            if (m_dense)
+            {
+                m_dense_set.set(key(id));
+            }
+            else
+            {
+                m_small_set.set(key(id));
+                m_sorted = false;
+            }
+        }
+
+        /**
+         * Check if the set contains an id. The small set is searched
+         * linearly until prepare_for_lookup() was called.
+         *
+         * Time complexity: Constant (dense), Logarithmic (small)
+         */
+        bool get(object_id_type id) const noexcept
+        {
+            if (m_dense)
+            {
+                return m_dense_set.get(key(id));
+            }
+            return m_sorted ? m_small_set.get_binary_search(key(id)) : m_small_set.get(key(id));
+        }
+
+        /**
+         * Sort the small set and remove duplicate ids, so that lookups use a
+         * binary search. This has to be called after all ids were added and
+         * before the set is shared between threads.
+         *
+         * Time complexity: Linearithmic
+         */
+        void prepare_for_lookup()
+        {
+            if (!m_dense && !m_sorted)
+            {
+                m_small_set.sort_unique();
+                m_sorted = true;
+            }
+        }
+
+        /**
+         * Add all ids of another set to this set.
+         *
+         * Time complexity: Linear in the size of the other set
+         */
+        void merge(const IdSet& other)
+        {
+            auto insert = [this](key_type value) {
+                if (m_dense)
+                {
+                    m_dense_set.set(value);
+                }
+                else
+                {
+                    m_small_set.set(value);
+                    m_sorted = false;
+                }
+            };
+            if (other.m_dense)
+            {
+                for (const key_type& value : other.m_dense_set)
+                {
+                    insert(value);
+                }
+            }
+            else
+            {
+                for (const key_type& value : other.m_small_set)
+                {
+                    insert(value);
+                }
+            }
+        }
+
+        void clear()
+        {
+            m_dense_set.clear();
+            m_small_set.clear();
+            m_sorted = true;
+        }
+
+    };
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+namespace model
+{
+
+    /**
+     * The fixed-size header of a buffer snapshot file, which precedes the
+     * committed bytes of the osmium buffer. The header size is a multiple
+     * of the osmium buffer alignment, so that the buffer data starts at an
+     * aligned offset.
+     *
+     * The buffer data is optionally followed by the node significance
+     * ranking of the compression, which contains one double value for each
+     * node of the buffer in the order of the buffer.
+     */
+    struct SnapshotHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+        std::uint64_t size;
+        std::uint64_t hash;
+        std::uint64_t ranks;
+        std::uint64_t ranks_hash;
+    };
+
+}
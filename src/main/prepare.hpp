@@ -7,6 +7,12 @@
 #include "routine.hpp"
 #include "io/reader/osm_reader.hpp"
 #include "io/writer/osm_writer.hpp"
+#include "io/writer/snapshot_writer.hpp"
+
+#include "mapmaker/compressor.hpp"
+#include "mapmaker/locator.hpp"
+#include "mapmaker/renumberer.hpp"
+#include "mapmaker/stripper.hpp"
 
 #include "util/log.hpp"
 #include "util/validate.hpp"
@@ -35,6 +41,39 @@ class Prepare : public Routine
     */
     std::string m_format;
 
+    /**
+     * The type of the node location index, e.g. "flex_mem" or
+     * "sparse_file_array".
+     */
+    std::string m_location_index;
+
+    /**
+     * The strip flag. If set to true, the object metadata and all tags that
+     * are not read by the create routine are removed from the prepared file.
+     */
+    bool m_strip;
+
+    /**
+     * The snapshot flag. If set to true, the prepared buffer is additionally
+     * written to a binary snapshot file, which can be loaded by the create
+     * routine without decoding.
+     */
+    bool m_snapshot;
+
+    /**
+     * The rank flag. If set to true, the node significance ranking for the
+     * compression is calculated and stored in the snapshot file, so that the
+     * create routine can compress the ways with any tolerance without
+     * running the Douglas-Peucker algorithm.
+     */
+    bool m_rank;
+
+    /**
+     * The low memory flag. If set to true, the boundaries are read with a
+     * strategy that only stores ids instead of whole ways.
+     */
+    bool m_low_memory;
+
     /**
     * The logger.
     */
@@ -50,6 +89,11 @@ public:
             ("input", po::value<fs::path>()->required(), "Sets the input file path.\nAllowed file formats: .osm, .pbf")
             ("outdir,o", po::value<fs::path>()->default_value(""), "Sets the output directory of the prepared boundaries file. If not set, the file will be stored in the executable directory.")
             ("format,f", po::value<std::string>()->default_value("osm.pbf"), "Sets the output format.\n Allowed formats: osm, pbf")
+            ("location-index", po::value<std::string>()->default_value("flex_mem"), "Sets the type of the node location index. File-backed indexes are stored in the output directory.\nAllowed types: flex_mem, dense_mem_array, sparse_mem_array, dense_mmap_array, sparse_mmap_array, dense_file_array, sparse_file_array")
+            ("strip,s", po::bool_switch()->default_value(false), "Removes the object metadata and all tags except admin_level, name, type, boundary and area from the prepared file.")
+            ("snapshot", po::bool_switch()->default_value(false), "Additionally writes the prepared boundaries to a binary .wzbuf snapshot file, which the create command loads without decoding.")
+            ("rank", po::bool_switch()->default_value(false), "Calculates the node significance ranking for the compression and stores it in the snapshot file. Implies --snapshot.")
+            ("low-memory", po::bool_switch()->default_value(false), "Reduces the memory usage when reading large input files by only storing ids instead of whole ways. The ways of incomplete boundaries will be kept in the result.")
             ("help,h", "Shows this help message");
         m_positional.add("input", 1);
     }
@@ -67,7 +111,13 @@ public:
         this->set<fs::path>(&m_input, "input", util::validate_file);
         this->set<fs::path>(&m_outdir, "outdir", m_dir, util::validate_dir);
         this->set<std::string>(&m_format, "format", util::validate_format);
-        m_log.set_steps(2);
+        this->set<std::string>(&m_location_index, "location-index", util::validate_location_index);
+        this->set<bool>(&m_strip, "strip");
+        this->set<bool>(&m_snapshot, "snapshot");
+        this->set<bool>(&m_rank, "rank");
+        m_snapshot = m_snapshot || m_rank;
+        this->set<bool>(&m_low_memory, "low-memory");
+        m_log.set_steps(3 + m_strip + m_rank + m_snapshot);
     }
 
     void run() override
@@ -75,9 +125,50 @@ public:
         // Read the boundaries from the specified input file
         m_log.start() << "Preparing file " << m_input << ".\n";
         io::BoundaryReader reader{m_input};
+        reader.low_memory(m_low_memory);
         osmium::memory::Buffer buffer = reader.read();
+        m_log.finish(fs::file_size(m_input));
+
+        // Resolve the node locations of the ways, so that they can be
+        // written to the prepared file
+        m_log.start() << "Resolving node locations with index type " << m_location_index << ".\n";
+        {
+            mapmaker::Locator locator{ m_location_index, m_outdir };
+            locator.run(buffer);
+        }
         m_log.finish();
+
+        // Remove the metadata and the tags that are not needed for the map
+        // creation if the strip flag was set
+        if (m_strip)
+        {
+            m_log.start() << "Stripping metadata and tags.\n";
+            mapmaker::Stripper stripper;
+            stripper.run(buffer);
+            m_log.finish();
+        }
         
+        // Calculate the node significance ranking for the snapshot if the
+        // rank flag was set. The ranking works on dense ids, so the buffer
+        // is renumbered for the ranking and restored afterwards. The ranking
+        // is stored in the order of the nodes in the buffer.
+        std::vector<double> significance;
+        if (m_rank)
+        {
+            m_log.start() << "Ranking node significance for the compression.\n";
+            mapmaker::Renumberer renumberer;
+            renumberer.run(buffer);
+            mapmaker::Compressor compressor{ 0.0 };
+            std::vector<double> ranking = compressor.rank(buffer);
+            for (const osmium::Node& node : buffer.select<osmium::Node>())
+            {
+                significance.push_back(ranking.at(node.positive_id()));
+            }
+            renumberer.restore(buffer);
+            m_log.step() << "Ranked " << significance.size() << " nodes in " << compressor.arcs() << " arcs.\n";
+            m_log.finish();
+        }
+
         // Prepare the outfile path
         std::string outfile_name = std::regex_replace(
             m_input.filename().string(),
@@ -87,9 +178,22 @@ public:
         outfile_name += "-prepared";
         fs::path outfile_path = m_outdir / fs::path(outfile_name).replace_extension(m_format);
 
+        // Write the boundaries to the snapshot file if the snapshot flag was
+        // set. The snapshot writer receives a non-owning view of the buffer,
+        // so the buffer can still be written to the output afterwards.
+        if (m_snapshot)
+        {
+            fs::path snapshot_path = m_outdir / fs::path(outfile_name).replace_extension(io::SNAPSHOT_EXTENSION);
+            m_log.start() << "Writing boundary snapshot to file " << snapshot_path << ".\n";
+            io::SnapshotWriter snapshot_writer{ snapshot_path };
+            snapshot_writer.significance(std::move(significance));
+            snapshot_writer.write(osmium::memory::Buffer{ buffer.data(), buffer.committed() });
+            m_log.finish();
+        }
+
         // Write the boundaries to the output
         m_log.start() << "Writing boundaries to file " << outfile_path << ".\n";
-        io::BoundaryWriter writer{outfile_path};
+        io::BoundaryWriter writer{outfile_path, true, !m_strip};
         writer.write(std::move(buffer));
         m_log.finish();
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "model/fingerprint.hpp"
+#include "util/hash.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace util
+{
+
+    /* Constants */
+
+    /**
+     * The number of bytes at the start and the end of a file that are
+     * hashed for its fingerprint.
+     */
+    const std::size_t FINGERPRINT_BLOCK_SIZE = 64 * 1024;
+
+    /* Functions */
+
+    /**
+     * Retrieves the path of a sidecar cache file, which is stored next to
+     * the specified file.
+     *
+     * @param path      The file path
+     * @param extension The extension of the cache file
+     * @returns         The cache file path
+     */
+    inline fs::path cache_path(const fs::path& path, std::string extension)
+    {
+        return fs::path{ path.string() + extension };
+    }
+
+    /**
+     * Calculates the fingerprint of a file from its size, its modification
+     * time and a content hash of its first and last block.
+     *
+     * @param path The file path
+     * @returns    The fingerprint of the file
+     * @throws     fs::filesystem_error if the file does not exist
+     */
+    inline model::Fingerprint fingerprint(const fs::path& path)
+    {
+        std::size_t size = fs::file_size(path);
+        std::time_t modified = fs::last_write_time(path);
+
+        // Hash the first and the last block of the file. For files that are
+        // smaller than two blocks, the blocks overlap.
+        std::ifstream ifs{ path.string(), std::ios::binary };
+        std::size_t block_size = std::min(size, FINGERPRINT_BLOCK_SIZE);
+        std::vector<char> block(block_size);
+        ifs.read(block.data(), block_size);
+        std::uint64_t hash = util::fnv1a(block.data(), ifs.gcount());
+        ifs.clear();
+        ifs.seekg(size - block_size);
+        ifs.read(block.data(), block_size);
+        hash = util::fnv1a(block.data(), ifs.gcount(), hash);
+
+        return model::Fingerprint{ size, modified, hash };
+    }
+
+}
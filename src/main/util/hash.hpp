@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace util
+{
+
+    /* Constants */
+
+    const std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    const std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+    /**
+     * Calculates the 64-bit FNV-1a hash of a byte sequence. The hash can be
+     * continued over multiple sequences by passing the previous result as
+     * the initial hash value.
+     *
+     * For more information on the algorithm, refer to
+     * https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
+     *
+     * @param data The byte sequence
+     * @param size The number of bytes
+     * @param hash The initial hash value
+     * @returns    The hash value
+     *
+     * Time complexity: Linear
+     */
+    inline std::uint64_t fnv1a(const void* data, std::size_t size, std::uint64_t hash = FNV_OFFSET_BASIS)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+}
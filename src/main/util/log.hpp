@@ -79,6 +79,22 @@ namespace util
             return "[Step " + std::to_string(step) + "/" + std::to_string(total) + "] ";
         }
 
+        long finish_step()
+        {
+            m_times.push_back(std::chrono::steady_clock::now());
+            long d = duration(m_step);
+            m_stream << step_header(m_step, m_steps) << "Finished after ";
+            if (d > 0)
+            {
+                m_stream << d;
+            }
+            else
+            {
+                m_stream << "< 1";
+            }
+            return d;
+        }
+
     public:
 
         /* Methods */
@@ -121,20 +137,22 @@ namespace util
 
         void finish()
         {
-            m_times.push_back(std::chrono::steady_clock::now());
-            long d = duration(m_step);
-            m_stream << step_header(m_step, m_steps) << "Finished after ";
-            if (d > 0)
-            {
-                m_stream << d;
-            }
-            else
-            {
-                m_stream << "< 1";
-            }
+            finish_step();
             m_stream << " ms." << std::endl;
         }
 
+        /**
+         * Finish the current step and report the throughput for the number
+         * of processed bytes next to the step duration.
+         *
+         * @param bytes The number of bytes processed in the current step
+         */
+        void finish(std::size_t bytes)
+        {
+            long d = finish_step();
+            m_stream << " ms (" << throughput(bytes, d) << " MB/s)." << std::endl;
+        }
+
         void end()
         {
             m_stream << "[End] Finished. Total execution time was " << total_duration() << " ms." << std::endl;
@@ -148,6 +166,13 @@ namespace util
             return duration_cast<std::chrono::milliseconds>(m_times.at(i + 1) - m_times.at(i)).count();
         }
 
+        long throughput(std::size_t bytes, long milliseconds)
+        {
+            // Steps that finished in less than a millisecond are treated as
+            // if they took exactly one millisecond
+            return static_cast<long>(bytes / 1000) / std::max(milliseconds, 1L);
+        }
+
         long total_duration()
         {
             return duration_cast<std::chrono::milliseconds>(m_times.back() - m_times.front()).count();
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace util
+{
+
+    /**
+     * Retrieves the number of threads that should be used for a requested
+     * thread count.
+     *
+     * @param threads The requested number of threads. If set to 0, the
+     *                number of hardware threads is used.
+     * @returns       The number of threads, which is at least 1
+     */
+    inline std::size_t thread_count(std::size_t threads)
+    {
+        if (threads == 0)
+        {
+            threads = std::thread::hardware_concurrency();
+        }
+        return threads > 0 ? threads : 1;
+    }
+
+    /**
+     * Sorts a range with multiple threads. The range is split into one
+     * chunk per thread, the chunks are sorted concurrently and merged
+     * pairwise afterwards, again concurrently within each merge round.
+     *
+     * @param first   The random access iterator to the first element
+     * @param last    The random access iterator after the last element
+     * @param threads The number of threads
+     * @param compare The comparison function
+     *
+     * Time complexity: Linearithmic
+     */
+    template <typename TIterator, typename TCompare = std::less<>>
+    void parallel_sort(TIterator first, TIterator last, std::size_t threads, TCompare compare = TCompare{})
+    {
+        std::size_t size = static_cast<std::size_t>(std::distance(first, last));
+        std::size_t chunks = std::min(thread_count(threads), size / 1024 + 1);
+        if (chunks <= 1)
+        {
+            std::sort(first, last, compare);
+            return;
+        }
+
+        // Calculate the chunk boundaries, where chunk i is the range
+        // [bounds[i], bounds[i + 1]).
+        std::vector<TIterator> bounds;
+        for (std::size_t i = 0; i < chunks; i++)
+        {
+            bounds.push_back(std::next(first, i * size / chunks));
+        }
+        bounds.push_back(last);
+
+        // Sort the chunks concurrently
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < chunks; i++)
+        {
+            workers.emplace_back([&bounds, &compare, i]() {
+                std::sort(bounds[i], bounds[i + 1], compare);
+            });
+        }
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+
+        // Merge neighboring chunks until a single sorted chunk is left
+        while (bounds.size() > 2)
+        {
+            workers.clear();
+            std::vector<TIterator> merged;
+            for (std::size_t i = 0; i + 2 < bounds.size(); i += 2)
+            {
+                workers.emplace_back([&bounds, &compare, i]() {
+                    std::inplace_merge(bounds[i], bounds[i + 1], bounds[i + 2], compare);
+                });
+                merged.push_back(bounds[i]);
+            }
+            if (bounds.size() % 2 == 0)
+            {
+                // The number of chunks is odd, so the last chunk is kept
+                // for the next round.
+                merged.push_back(bounds[bounds.size() - 2]);
+            }
+            merged.push_back(last);
+            for (std::thread& worker : workers)
+            {
+                worker.join();
+            }
+            bounds = std::move(merged);
+        }
+    }
+
+}
@@ -20,6 +20,18 @@ namespace util
 
     const std::vector<std::string> ALLOWED_OSM_FORMATS{ "osm", "pbf", "osm.pbf" };
 
+    const std::vector<std::string> ALLOWED_LOCATION_INDEX_TYPES{
+        "flex_mem",
+        "dense_mem_array",
+        "sparse_mem_array",
+        "dense_mmap_array",
+        "sparse_mmap_array",
+        "dense_file_array",
+        "sparse_file_array"
+    };
+
+    const std::vector<std::string> ALLOWED_COMPRESSION_ALGORITHMS{ "dp", "vw" };
+
 
     /* Simple Validation Functions */
 
@@ -89,6 +101,34 @@ namespace util
         }
     }
 
+    void validate_location_index(std::string& index_type, std::string name)
+    {
+        // Normalize index type
+        boost::to_lower(index_type);
+        // Check if the index type is valid
+        if (std::find(ALLOWED_LOCATION_INDEX_TYPES.begin(), ALLOWED_LOCATION_INDEX_TYPES.end(), index_type) == ALLOWED_LOCATION_INDEX_TYPES.end())
+        {
+            throw std::invalid_argument(
+                "The specified location index " + index_type + " for parameter '" + name + "' is not supported."
+                + "\nSupported location indexes are " + util::join(ALLOWED_LOCATION_INDEX_TYPES)
+            );
+        }
+    }
+
+    void validate_compression_algorithm(std::string& algorithm, std::string name)
+    {
+        // Normalize algorithm name
+        boost::to_lower(algorithm);
+        // Check if the algorithm is valid
+        if (std::find(ALLOWED_COMPRESSION_ALGORITHMS.begin(), ALLOWED_COMPRESSION_ALGORITHMS.end(), algorithm) == ALLOWED_COMPRESSION_ALGORITHMS.end())
+        {
+            throw std::invalid_argument(
+                "The specified compression algorithm " + algorithm + " for parameter '" + name + "' is not supported."
+                + "\nSupported compression algorithms are " + util::join(ALLOWED_COMPRESSION_ALGORITHMS)
+            );
+        }
+    }
+
     void validate_epsilon(double& epsilon, std::string name)
     {
         if (epsilon < 0)